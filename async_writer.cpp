@@ -0,0 +1,104 @@
+/**
+ * @file    async_writer.cpp
+ * @brief   Implements the asynchronous solution writer.
+ */
+
+#include "async_writer.h"
+
+#include <chrono>
+
+AsyncSolutionWriter::AsyncSolutionWriter(unsigned int board_size, FILE* output)
+    : n(board_size), out(output), writer_waiting(false), finishing(false), written_values(0)
+{
+    writer = std::thread(&AsyncSolutionWriter::run_writer, this);
+}
+
+AsyncSolutionWriter::~AsyncSolutionWriter()
+{
+    finish();
+}
+
+void AsyncSolutionWriter::add_solutions(const unsigned int* begin, const unsigned int* end)
+{
+    if(begin == end) return;
+    chunks.push(std::vector<unsigned int>(begin, end));
+    //only a sleeping writer needs the lock, the push itself never waits.  The fence pairs with the writer's
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if(writer_waiting.load())
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+}
+
+void AsyncSolutionWriter::finish()
+{
+    if(!writer.joinable()) return;
+    finishing.store(true);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+    writer.join();
+    fflush(out);
+}
+
+void AsyncSolutionWriter::run_writer()
+{
+    std::vector<unsigned int> chunk;
+    std::vector<char> text;
+    while(true)
+    {
+        if(chunks.pop(chunk))
+        {
+            write_chunk(chunk, text);
+            continue;
+        }
+        //checked after the queue was found empty: everything added before finish() has been written
+        if(finishing.load())
+        {
+            if(chunks.pop(chunk))
+            {
+                write_chunk(chunk, text);
+                continue;
+            }
+            return;
+        }
+        //announce the sleep before looking again, so a producer that pushes after the look wakes us
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        writer_waiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(chunks.pop(chunk))
+        {
+            writer_waiting.store(false);
+            lock.unlock();
+            write_chunk(chunk, text);
+            continue;
+        }
+        //the timeout only bounds the cost of a missed wake-up
+        if(!finishing.load()) wake.wait_for(lock, std::chrono::milliseconds(10));
+        writer_waiting.store(false);
+    }
+}
+
+void AsyncSolutionWriter::write_chunk(const std::vector<unsigned int>& chunk, std::vector<char>& text)
+{
+    //formatted by hand into one buffer per chunk: a value has at most 10 digits and a separator
+    text.resize(chunk.size() * 11);
+    char* pos = text.data();
+    for(size_t i = 0; i < chunk.size(); ++i)
+    {
+        char digits[10];
+        int length = 0;
+        unsigned int value = chunk[i];
+        do
+        {
+            digits[length++] = '0' + value % 10;
+            value /= 10;
+        } while(value > 0);
+        while(length > 0) *pos++ = digits[--length];
+        *pos++ = (i + 1) % n == 0 ? '\n' : ' ';
+    }
+    fwrite(text.data(), 1, pos - text.data(), out);
+    written_values += chunk.size();
+}
@@ -0,0 +1,62 @@
+/**
+ * @file    async_writer.h
+ * @brief   Declares a solution sink that prints the solutions on a writer
+ *          thread of its own while the search continues.
+ *
+ * The master hands over its solutions as they arrive (see solution_sink.h);
+ * the sink only copies them into a chunk and pushes it onto a lock-free
+ * queue (lockfree_queue.h), so the receive path never waits for the output.
+ * The writer thread formats the chunks in order and writes them to stdout,
+ * so a run with output takes about as long as the longer of the search and
+ * the output instead of their sum.
+ */
+
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdio.h>
+
+#include "solution_sink.h"
+#include "lockfree_queue.h"
+
+class AsyncSolutionWriter : public SolutionSink
+{
+public:
+    /**
+     * @brief Starts the writer thread, which prints solutions of `n` values, one per line, to `out`.
+     */
+    AsyncSolutionWriter(unsigned int n, FILE* out = stdout);
+    ~AsyncSolutionWriter();
+
+    //may be called from any thread; the chunks of one thread are written in the order they were added
+    void add_solutions(const unsigned int* begin, const unsigned int* end);
+
+    /**
+     * @brief Waits until everything added so far is written and stops the writer thread.
+     */
+    void finish();
+
+    //the number of solutions written; final after finish()
+    size_t num_solutions() const { return written_values / n; }
+
+private:
+    void run_writer();
+    void write_chunk(const std::vector<unsigned int>& chunk, std::vector<char>& text);
+
+    unsigned int n;
+    FILE* out;
+    MpscQueue<std::vector<unsigned int> > chunks;
+    std::atomic<bool> writer_waiting; //the writer found the queue empty and is about to sleep
+    std::atomic<bool> finishing;
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    size_t written_values;
+    std::thread writer;
+};
+
+#endif // ASYNC_WRITER_H
@@ -0,0 +1,160 @@
+/**
+ * @file    batch_main.cpp
+ * @brief   Implements the main routine of the batch solver, which solves a
+ *          file of many small completion problems and writes their results
+ *          in input order.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <chrono>
+
+#include "batch_solver.h"
+#include "nqueens_threads.h"
+#include "solution_sampler.h"
+
+
+/**
+ * Prints the usage of the program.
+ */
+void print_usage() {
+    std::cerr << "Usage: ./nqueens-batch [options] <instances> [<results>]" << std::endl;
+    std::cerr << "      Required arguments:" << std::endl;
+    std::cerr << "          <instances>  Instance file to solve (or to write, with -g)." << std::endl;
+    std::cerr << "          <results>    Result file to write, in the order of the instances." << std::endl;
+    std::cerr << "      Optional arguments:" << std::endl;
+    std::cerr << "          -j <p>      Number of solver threads (default: number of cores)." << std::endl;
+    std::cerr << "          -o          Also print the results to stdout: the instance number," << std::endl;
+    std::cerr << "                      the count and the first solution, if any." << std::endl;
+    std::cerr << "          -g <m>      Write m random instances to <instances> instead of solving." << std::endl;
+    std::cerr << "          -n <n>      Board size of the generated instances (default: 12, at most " << batch_max_n << ")." << std::endl;
+    std::cerr << "          -b <pct>    Percentage of blocked cells of the generated instances (default: 10)." << std::endl;
+    std::cerr << "          -f          Generate instances that only ask for the first solution." << std::endl;
+    std::cerr << "          -R <seed>   Seed of -g (default: the current time)." << std::endl;
+    std::cerr << "      Example:" << std::endl;
+    std::cerr << "          ./nqueens-batch -g 1000000 -n 10 -b 15 instances.bin" << std::endl;
+    std::cerr << "          ./nqueens-batch -j 8 instances.bin results.bin" << std::endl;
+}
+
+/**
+ * @brief Generates random instances: every cell is blocked with the given probability.
+ */
+std::vector<BatchInstance> generate_instances(size_t m, unsigned int n, unsigned int blocked_percent, Solve_Mode mode, uint64_t seed)
+{
+    std::vector<BatchInstance> instances(m, batch_instance(Problem(n), mode));
+    for(size_t i = 0; i < m; ++i)
+    {
+        SampleRandom random(seed, i);
+        for(unsigned int row = 0; row < n; ++row)
+            for(unsigned int column = 0; column < n; ++column)
+                if(random.below(100) < blocked_percent) instances[i].allowed[row] &= ~(1u << column);
+    }
+    return instances;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int num_threads = default_num_threads();
+    bool opt_print = false;
+    size_t opt_generate = 0;
+    int opt_n = 12;
+    int opt_blocked = 10;
+    Solve_Mode opt_mode = count_mode;
+    unsigned long long opt_seed = time(NULL);
+
+    // forget about first argument (which is the executable's name)
+    argc--;
+    argv++;
+
+    // parse optional parameters
+    while (argc > 0 && argv[0][0] == '-') {
+        char option = argv[0][1];
+        // the options without a value
+        if (option == 'o' || option == 'f') {
+            if (option == 'o')
+                opt_print = true;
+            else
+                opt_mode = first_mode;
+            argv++;
+            argc--;
+            continue;
+        }
+        if (argc < 2) {
+            print_usage();
+            exit(EXIT_FAILURE);
+        }
+        switch (option) {
+            case 'j':
+                num_threads = atoi(argv[1]);
+                break;
+            case 'g':
+                opt_generate = atol(argv[1]);
+                break;
+            case 'n':
+                opt_n = atoi(argv[1]);
+                break;
+            case 'b':
+                opt_blocked = atoi(argv[1]);
+                break;
+            case 'R':
+                opt_seed = strtoull(argv[1], NULL, 10);
+                break;
+            default:
+                print_usage();
+                exit(EXIT_FAILURE);
+        }
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (num_threads == 0 || opt_n <= 0 || opt_n > (int) batch_max_n || opt_blocked < 0 || opt_blocked > 100
+        || argc != (opt_generate > 0 ? 1 : 2)) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    if (opt_generate > 0) {
+        std::vector<BatchInstance> instances = generate_instances(opt_generate, opt_n, opt_blocked, opt_mode, opt_seed);
+        if (!write_batch_instances(argv[0], instances)) {
+            std::cerr << "[ERROR]: Could not write the instances to " << argv[0] << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        std::cerr << "Wrote " << instances.size() << " instances (seed " << opt_seed << ") to " << argv[0] << std::endl;
+        return 0;
+    }
+
+    std::vector<BatchInstance> instances;
+    if (!read_batch_instances(argv[0], instances)) {
+        std::cerr << "[ERROR]: " << argv[0] << " is not a valid instance file" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // the file I/O is not timed
+    std::vector<BatchResult> results(instances.size());
+    SolverPool pool(num_threads);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t invalid = solve_batch(instances.data(), instances.size(), results.data(), pool);
+    double time_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (invalid > 0)
+        std::cerr << "[WARNING]: " << invalid << " instances have an invalid board size" << std::endl;
+    if (!write_batch_results(argv[1], results)) {
+        std::cerr << "[ERROR]: Could not write the results to " << argv[1] << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (opt_print) {
+        for (size_t i = 0; i < results.size(); ++i) {
+            std::cout << i << " " << results[i].count;
+            for (unsigned int row = 0; results[i].count > 0 && row < instances[i].n; ++row)
+                std::cout << " " << (unsigned int) results[i].first[row];
+            std::cout << std::endl;
+        }
+    }
+    fprintf(stderr, "Solved %zu instances in %.0lf milli-seconds (%.0lf instances per second)\n",
+            instances.size(), time_secs * 1000.0, time_secs > 0 ? instances.size() / time_secs : 0.0);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file    batch_solver.cpp
+ * @brief   Implements the batch solver for many small completion problems.
+ */
+
+#include "batch_solver.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "nqueens_threads.h"
+
+//instances solved by one pool task
+const size_t instances_per_task = 256;
+
+BatchInstance batch_instance(const Problem& problem, Solve_Mode mode)
+{
+    BatchInstance instance;
+    memset(&instance, 0, sizeof(instance));
+    instance.n = problem.n;
+    instance.mode = mode;
+    for(unsigned int row = 0; row < problem.n && row < batch_max_n; ++row)
+        instance.allowed[row] = static_cast<uint16_t>(problem.allowed[row]);
+    return instance;
+}
+
+bool solve_instance(const BatchInstance& instance, BatchResult& result)
+{
+    result.count = 0;
+    memset(result.first, 0xff, sizeof(result.first));
+    unsigned int n = instance.n;
+    if(n == 0 || n > batch_max_n) return false;
+
+    //the search state of every level lives on the stack: nothing is allocated per instance
+    uint32_t all_columns = (1u << n) - 1;
+    uint32_t untried[batch_max_n], columns[batch_max_n], left_diagonals[batch_max_n], right_diagonals[batch_max_n];
+    uint8_t pos[batch_max_n];
+    unsigned int level = 0;
+    columns[0] = left_diagonals[0] = right_diagonals[0] = 0;
+    untried[0] = all_columns & instance.allowed[0];
+    while(true)
+    {
+        if(untried[level] == 0)
+        {
+            if(level == 0) break;
+            --level;
+            continue;
+        }
+        if(level == n - 1)
+        {
+            //every free column of the last row completes a solution, the lowest one is the first
+            if(result.count == 0)
+            {
+                std::copy(pos, pos + level, result.first);
+                result.first[level] = __builtin_ctz(untried[level]);
+            }
+            if(instance.mode == first_mode)
+            {
+                result.count = 1;
+                break;
+            }
+            result.count += __builtin_popcount(untried[level]);
+            untried[level] = 0;
+            continue;
+        }
+        uint32_t queen = untried[level] & (~untried[level] + 1);
+        untried[level] &= untried[level] - 1;
+        pos[level] = __builtin_ctz(queen);
+        columns[level + 1] = columns[level] | queen;
+        left_diagonals[level + 1] = ((left_diagonals[level] | queen) << 1) & all_columns;
+        right_diagonals[level + 1] = (right_diagonals[level] | queen) >> 1;
+        ++level;
+        untried[level] = ~(columns[level] | left_diagonals[level] | right_diagonals[level]) & all_columns & instance.allowed[level];
+    }
+    return true;
+}
+
+size_t solve_batch(const BatchInstance* instances, size_t count, BatchResult* results, SolverPool& pool)
+{
+    size_t num_tasks = (count + instances_per_task - 1) / instances_per_task;
+    std::vector<size_t> invalid(num_tasks, 0);
+    pool.run_tasks(num_tasks, [&](size_t task) {
+        size_t end = std::min(count, (task + 1) * instances_per_task);
+        for(size_t i = task * instances_per_task; i < end; ++i)
+            if(!solve_instance(instances[i], results[i])) ++invalid[task];
+    });
+    size_t num_invalid = 0;
+    for(size_t task = 0; task < num_tasks; ++task) num_invalid += invalid[task];
+    return num_invalid;
+}
+
+/**
+ * @brief Reads the records of a batch file with the given magic.
+ */
+template <class Record>
+bool read_batch_file(const std::string& path, uint32_t magic, std::vector<Record>& records)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file == NULL) return false;
+    BatchFileHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == magic && header.version == batch_format_version;
+    if(ok)
+    {
+        records.resize(header.count);
+        ok = (records.empty() || fread(records.data(), sizeof(Record), records.size(), file) == records.size())
+             && fgetc(file) == EOF;
+    }
+    fclose(file);
+    if(!ok) records.clear();
+    return ok;
+}
+
+/**
+ * @brief Writes the records of a batch file with the given magic, under a temporary name first.
+ */
+template <class Record>
+bool write_batch_file(const std::string& path, uint32_t magic, const std::vector<Record>& records)
+{
+    BatchFileHeader header;
+    header.magic = magic;
+    header.version = batch_format_version;
+    header.count = records.size();
+    std::string temp_path = path + ".tmp." + std::to_string(getpid());
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if(file == NULL) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+              && (records.empty() || fwrite(records.data(), sizeof(Record), records.size(), file) == records.size());
+    ok = (fclose(file) == 0) && ok;
+    if(!ok || rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool read_batch_instances(const std::string& path, std::vector<BatchInstance>& instances)
+{
+    return read_batch_file(path, batch_instance_magic, instances);
+}
+
+bool write_batch_instances(const std::string& path, const std::vector<BatchInstance>& instances)
+{
+    return write_batch_file(path, batch_instance_magic, instances);
+}
+
+bool write_batch_results(const std::string& path, const std::vector<BatchResult>& results)
+{
+    return write_batch_file(path, batch_result_magic, results);
+}
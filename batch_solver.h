@@ -0,0 +1,90 @@
+/**
+ * @file    batch_solver.h
+ * @brief   Declares the batch solver for many small completion problems,
+ *          and the binary file formats of its instances and results.
+ *
+ * Small instances (n <= 16) take microseconds each, so the per instance
+ * setup of the general solvers (allocating vectors, splitting into tasks,
+ * messages) would dominate.  The batch solver instead runs an allocation-free
+ * bit mask search on fixed size records and hands the solver threads blocks
+ * of consecutive instances, so that the setup cost is paid once per block.
+ */
+
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "nqueens_mode.h"
+#include "problem.h"
+
+class SolverPool;
+
+//largest board size of an instance (a row is a 16 bit mask)
+const unsigned int batch_max_n = 16;
+
+//"NQBI" and "NQBR" in a little endian file
+const uint32_t batch_instance_magic = 0x4942514e;
+const uint32_t batch_result_magic = 0x5242514e;
+const uint32_t batch_format_version = 1;
+
+//the header of an instance file and of a result file, followed by `count` records
+struct BatchFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t count;
+};
+
+//one instance: a board of n rows with the allowed columns of every row, as in problem.h
+struct BatchInstance
+{
+    uint32_t n;
+    uint32_t mode;              //Solve_Mode: count_mode counts all solutions, first_mode stops at the first
+    uint16_t allowed[batch_max_n];
+};
+
+//the result of one instance
+struct BatchResult
+{
+    uint64_t count;             //the number of solutions (0 or 1 in first mode)
+    uint8_t first[batch_max_n]; //the lexicographically first solution, 0xff for every row if there is none
+};
+
+/**
+ * @brief Converts a problem of at most batch_max_n rows into an instance.
+ */
+BatchInstance batch_instance(const Problem& problem, Solve_Mode mode);
+
+/**
+ * @brief Solves one instance on the calling thread.  Returns false if the instance is invalid.
+ */
+bool solve_instance(const BatchInstance& instance, BatchResult& result);
+
+/**
+ * @brief Solves all instances on the solver pool, in blocks of consecutive
+ *        instances.  results[i] is the result of instances[i].
+ *
+ * @returns the number of invalid instances, whose results are left empty.
+ */
+size_t solve_batch(const BatchInstance* instances, size_t count, BatchResult* results, SolverPool& pool);
+
+/**
+ * @brief Reads an instance file.  Returns false if it is missing or not a valid instance file.
+ */
+bool read_batch_instances(const std::string& path, std::vector<BatchInstance>& instances);
+
+/**
+ * @brief Writes an instance file.
+ */
+bool write_batch_instances(const std::string& path, const std::vector<BatchInstance>& instances);
+
+/**
+ * @brief Writes a result file, under a temporary name first like the solution files.
+ */
+bool write_batch_results(const std::string& path, const std::vector<BatchResult>& results);
+
+#endif // BATCH_SOLVER_H
@@ -0,0 +1,104 @@
+/**
+ * @file    compressed_store.cpp
+ * @brief   Implements the prefix-delta compressed solution store.
+ */
+
+#include "compressed_store.h"
+
+#include <algorithm>
+
+CompressedSolutionStore::CompressedSolutionStore(unsigned int n, unsigned int restart_interval)
+    : board_size(n), interval(restart_interval > 0 ? restart_interval : 1), field_bits(1), num_sols(0), num_bits(0), previous(n, 0)
+{
+    //the shared prefix length goes up to n, the entries up to n-1
+    while((1u << field_bits) <= n) ++field_bits;
+}
+
+void CompressedSolutionStore::put(unsigned int value)
+{
+    //a field spans at most two bytes, since it has at most 8 bits
+    size_t byte = num_bits / 8;
+    unsigned int shift = num_bits % 8;
+    if(bytes.size() < (num_bits + field_bits + 7) / 8) bytes.resize((num_bits + field_bits + 7) / 8, 0);
+    bytes[byte] |= static_cast<unsigned char>(value << shift);
+    if(shift + field_bits > 8) bytes[byte + 1] |= static_cast<unsigned char>(value >> (8 - shift));
+    num_bits += field_bits;
+}
+
+unsigned int CompressedSolutionStore::read(size_t bit_offset) const
+{
+    size_t byte = bit_offset / 8;
+    unsigned int shift = bit_offset % 8;
+    unsigned int value = bytes[byte] >> shift;
+    if(shift + field_bits > 8) value |= static_cast<unsigned int>(bytes[byte + 1]) << (8 - shift);
+    return value & ((1u << field_bits) - 1);
+}
+
+void CompressedSolutionStore::add_solutions(const unsigned int* begin, const unsigned int* end)
+{
+    for(const unsigned int* solution = begin; solution < end; solution += board_size) add_solution(solution);
+}
+
+void CompressedSolutionStore::add_solution(const unsigned int* solution)
+{
+    unsigned int shared = 0;
+    if(num_sols % interval == 0) restarts.push_back(num_bits); //stored in full
+    else
+        while(shared < board_size && solution[shared] == previous[shared]) ++shared;
+
+    put(shared);
+    for(unsigned int i = shared; i < board_size; ++i) put(solution[i]);
+    std::copy(solution, solution + board_size, previous.begin());
+    ++num_sols;
+}
+
+void CompressedSolutionStore::shrink_to_fit()
+{
+    std::vector<unsigned char>(bytes).swap(bytes);
+    std::vector<uint64_t>(restarts).swap(restarts);
+}
+
+void CompressedSolutionStore::get(size_t index, unsigned int* solution) const
+{
+    Cursor cursor(*this, index);
+    cursor.next();
+    std::copy(cursor.solution(), cursor.solution() + board_size, solution);
+}
+
+std::vector<unsigned int> CompressedSolutionStore::decompress() const
+{
+    std::vector<unsigned int> solutions;
+    solutions.reserve(num_sols * board_size);
+    Cursor cursor(*this);
+    while(cursor.next()) solutions.insert(solutions.end(), cursor.solution(), cursor.solution() + board_size);
+    return solutions;
+}
+
+CompressedSolutionStore::Cursor::Cursor(const CompressedSolutionStore& s, size_t index)
+    : store(s), current(s.board_size, 0), offset(0), position(0)
+{
+    if(index >= store.num_sols)
+    {
+        position = store.num_sols;
+        offset = store.num_bits;
+        return;
+    }
+    //start at the restart point before the index and decode up to it
+    position = index - index % store.interval;
+    offset = store.restarts[index / store.interval];
+    while(position < index) next();
+}
+
+bool CompressedSolutionStore::Cursor::next()
+{
+    if(position >= store.num_sols) return false;
+    unsigned int shared = store.read(offset);
+    offset += store.field_bits;
+    for(unsigned int i = shared; i < store.board_size; ++i)
+    {
+        current[i] = store.read(offset);
+        offset += store.field_bits;
+    }
+    ++position;
+    return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file    compressed_store.h
+ * @brief   Declares a prefix-delta compressed in-memory solution store, an
+ *          alternative to keeping solutions as flat `unsigned int`s.
+ *
+ * Solutions arriving in lexicographic order share long prefixes with their
+ * predecessor.  Each solution is stored as the length of the prefix it shares
+ * with the previous solution, followed by the remaining entries, all packed
+ * into a bit stream with just enough bits per field to hold `n` (4 bits up to
+ * n = 15).  Every `restart_interval` solutions a restart point stores the
+ * solution in full, so solution `i` is decoded from the restart point before
+ * it without touching the rest of the store.
+ */
+
+#ifndef COMPRESSED_STORE_H
+#define COMPRESSED_STORE_H
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "solution_sink.h"
+
+//solutions between restart points
+const unsigned int default_restart_interval = 64;
+
+/**
+ * @brief Stores solutions of one board size compressed, in the order they are added.
+ *
+ * Supports boards of up to 255 rows, so every field fits in a byte.
+ */
+class CompressedSolutionStore : public SolutionSink
+{
+public:
+    static const unsigned int max_n = 255;
+
+    explicit CompressedSolutionStore(unsigned int n, unsigned int restart_interval = default_restart_interval);
+
+    void add_solutions(const unsigned int* begin, const unsigned int* end);
+    void add_solution(const unsigned int* solution);
+
+    unsigned int n() const { return board_size; }
+    //the number of stored solutions
+    size_t size() const { return num_sols; }
+    //the memory used by the compressed solutions and the restart points
+    size_t memory_bytes() const { return bytes.capacity() + restarts.capacity() * sizeof(uint64_t); }
+
+    /**
+     * @brief Releases the memory reserved for solutions that are not added after all.
+     */
+    void shrink_to_fit();
+
+    /**
+     * @brief Decodes solution `index` into `solution`, which has room for n() entries.
+     */
+    void get(size_t index, unsigned int* solution) const;
+
+    /**
+     * @brief Returns all solutions as flat, concatenated `unsigned int`s.
+     */
+    std::vector<unsigned int> decompress() const;
+
+    /**
+     * @brief Iterates over the solutions in order, starting at a given index.
+     *
+     *     CompressedSolutionStore::Cursor cursor(store);
+     *     while(cursor.next()) use(cursor.solution());
+     */
+    class Cursor
+    {
+    public:
+        explicit Cursor(const CompressedSolutionStore& store, size_t index = 0);
+
+        /**
+         * @brief Decodes the next solution.  Returns false after the last one.
+         */
+        bool next();
+        const unsigned int* solution() const { return current.data(); }
+        //the index of the solution returned by solution()
+        size_t index() const { return position - 1; }
+
+    private:
+        const CompressedSolutionStore& store;
+        std::vector<unsigned int> current;
+        size_t offset; //bit offset of the next encoded solution
+        size_t position; //index of the next solution
+    };
+
+private:
+    void put(unsigned int value);
+    unsigned int read(size_t bit_offset) const;
+
+    unsigned int board_size;
+    unsigned int interval;
+    unsigned int field_bits; //bits per stored field
+    size_t num_sols;
+    std::vector<unsigned char> bytes;
+    size_t num_bits; //bits of `bytes` in use
+    std::vector<uint64_t> restarts; //bit offset of every restart point
+    std::vector<unsigned int> previous; //the last added solution
+};
+
+#endif // COMPRESSED_STORE_H
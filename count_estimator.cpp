@@ -0,0 +1,93 @@
+/**
+ * @file    count_estimator.cpp
+ * @brief   Implements the Monte Carlo estimator of the number of solutions.
+ */
+
+#include "count_estimator.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include "nqueens_threads.h"
+
+//probes run by one pool task
+const uint64_t probes_per_task = 1000;
+
+double EstimateStats::half_width() const
+{
+    if(probes < 2) return INFINITY;
+    double variance = (sum_squares - sum * sum / probes) / (probes - 1);
+    return 1.96 * sqrt(std::max(variance, 0.0) / probes);
+}
+
+double weighted_probe(unsigned int n, SampleRandom& random)
+{
+    BoardMasks board(n);
+    double estimate = 1.0;
+    unsigned int weights[max_sample_n];
+    uint64_t columns[max_sample_n];
+    while(board.row + 1 < n)
+    {
+        //weight every free column by the free columns it leaves in the next row
+        uint64_t free = board.free();
+        unsigned int choices = 0, total = 0;
+        for(; free != 0; free &= free - 1)
+        {
+            BoardMasks child = board;
+            child.place(__builtin_ctzll(free));
+            columns[choices] = __builtin_ctzll(free);
+            weights[choices] = __builtin_popcountll(child.free());
+            total += weights[choices++];
+        }
+        if(total == 0) return 0.0; //every choice is a dead end
+        unsigned int target = random.below(total), choice = 0;
+        while(target >= weights[choice]) target -= weights[choice++];
+        //the path was taken with probability weight / total
+        estimate *= static_cast<double>(total) / weights[choice];
+        board.place(columns[choice]);
+    }
+    //every free column of the last row completes a solution
+    return estimate * __builtin_popcountll(board.free());
+}
+
+EstimateStats run_probes(unsigned int n, uint64_t seed, uint64_t first, uint64_t count)
+{
+    EstimateStats stats;
+    for(uint64_t i = first; i < first + count; ++i)
+    {
+        SampleRandom random(seed, i);
+        stats.add(weighted_probe(n, random));
+    }
+    return stats;
+}
+
+void print_estimate(std::ostream& out, const EstimateStats& stats)
+{
+    char line[160];
+    double mean = stats.mean(), half_width = stats.half_width();
+    snprintf(line, sizeof(line), "estimate %.6e +- %.3e (95%% confidence, %.2f%%) after %.0f probes",
+             mean, half_width, mean > 0 ? 100.0 * half_width / mean : 0.0, stats.probes);
+    out << line << std::endl;
+}
+
+EstimateStats estimate_count(unsigned int n, uint64_t seed, uint64_t num_probes, SolverPool& pool)
+{
+    EstimateStats total;
+    for(uint64_t round_start = 0; round_start < num_probes; round_start += estimate_round_probes)
+    {
+        uint64_t round_probes = std::min(estimate_round_probes, num_probes - round_start);
+        size_t num_tasks = (round_probes + probes_per_task - 1) / probes_per_task;
+        std::vector<EstimateStats> task_stats(num_tasks);
+        pool.run_tasks(num_tasks, [&](size_t task) {
+            uint64_t first = task * probes_per_task;
+            task_stats[task] = run_probes(n, seed, round_start + first, std::min(probes_per_task, round_probes - first));
+        });
+        //merge in task order, so the result does not depend on the number of threads
+        for(size_t task = 0; task < num_tasks; ++task) total.merge(task_stats[task]);
+        print_estimate(std::cerr, total);
+    }
+    return total;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file    count_estimator.h
+ * @brief   Declares the Monte Carlo estimator of the number of solutions, for
+ *          boards beyond the reach of exact counting.
+ *
+ * The estimator is Knuth's: a random probe descends from the root to a leaf
+ * and returns the inverse of the probability of the path it took if the leaf
+ * is a solution, and 0 otherwise; the mean over many probes converges to
+ * the number of solutions.  The probes here use importance weighting: each
+ * queen is chosen with probability proportional to the number of free
+ * columns it leaves in the next row, which steers the probes away from dead
+ * ends and lowers the variance compared with uniform choices.  Probe i
+ * uses the random stream (seed, i), see solution_sampler.h, so the probes can
+ * be split between any number of threads or ranks.
+ */
+
+#ifndef COUNT_ESTIMATOR_H
+#define COUNT_ESTIMATOR_H
+
+#include <ostream>
+#include <stdint.h>
+
+#include "solution_sampler.h"
+
+class SolverPool;
+
+//probes per reporting round, split between all threads or ranks
+const uint64_t estimate_round_probes = 100000;
+
+/**
+ * @brief The running sums of the probe results.  Doubles, so that they can
+ *        be summed over MPI ranks with a single MPI_Allreduce.
+ */
+struct EstimateStats
+{
+    double probes;
+    double sum;
+    double sum_squares;
+
+    EstimateStats() : probes(0), sum(0), sum_squares(0) {}
+
+    void add(double estimate) { probes += 1; sum += estimate; sum_squares += estimate * estimate; }
+    void merge(const EstimateStats& other) { probes += other.probes; sum += other.sum; sum_squares += other.sum_squares; }
+
+    //the estimated number of solutions
+    double mean() const { return probes > 0 ? sum / probes : 0; }
+
+    //the half width of the 95% confidence interval of the mean (normal approximation)
+    double half_width() const;
+};
+
+/**
+ * @brief One importance weighted probe of the n x n board, n <= max_sample_n.
+ */
+double weighted_probe(unsigned int n, SampleRandom& random);
+
+/**
+ * @brief Runs the probes [first, first + count) of the given seed on the calling thread.
+ */
+EstimateStats run_probes(unsigned int n, uint64_t seed, uint64_t first, uint64_t count);
+
+/**
+ * @brief Prints the estimate, its confidence interval and the number of probes in one line.
+ */
+void print_estimate(std::ostream& out, const EstimateStats& stats);
+
+/**
+ * @brief Estimates the number of solutions with `num_probes` probes on the
+ *        solver pool, printing the estimate to stderr after every round.
+ */
+EstimateStats estimate_count(unsigned int n, uint64_t seed, uint64_t num_probes, SolverPool& pool);
+
+#endif // COUNT_ESTIMATOR_H
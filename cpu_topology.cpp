@@ -0,0 +1,211 @@
+/**
+ * @file    cpu_topology.cpp
+ * @brief   Implements the NUMA topology and thread pinning.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "cpu_topology.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#endif
+
+//the kernel's NUMA nodes
+const char* const sys_node_dir = "/sys/devices/system/node";
+
+unsigned int CpuTopology::num_cpus() const
+{
+    unsigned int cpus = 0;
+    for(size_t node = 0; node < node_cpus.size(); ++node) cpus += node_cpus[node].size();
+    return cpus;
+}
+
+bool parse_cpu_list(const std::string& list, std::vector<unsigned int>& cpus)
+{
+    cpus.clear();
+    std::stringstream ranges(list);
+    std::string range;
+    while(std::getline(ranges, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if(range.empty()) continue;
+        char* end;
+        unsigned long first = strtoul(range.c_str(), &end, 10), last = first;
+        if(end == range.c_str()) return false;
+        if(*end == '-')
+        {
+            const char* second = end + 1;
+            last = strtoul(second, &end, 10);
+            if(end == second || last < first) return false;
+        }
+        if(*end != '\0') return false;
+        for(unsigned long cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the CPUs the process may run on.
+ */
+std::vector<unsigned int> usable_cpus()
+{
+    std::vector<unsigned int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    if(sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for(unsigned int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if(CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+#endif
+    if(cpus.empty())
+    {
+        unsigned int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+        for(unsigned int cpu = 0; cpu < num_cpus; ++cpu) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+//the kernel ids of the nodes in CpuTopology::node_cpus, to map page locations back
+std::vector<int>& topology_node_ids()
+{
+    static std::vector<int> node_ids;
+    return node_ids;
+}
+
+/**
+ * @brief Reads the topology: every node directory with usable CPUs becomes a node.
+ */
+CpuTopology read_cpu_topology()
+{
+    CpuTopology topology;
+    std::vector<unsigned int> usable = usable_cpus();
+    std::vector<std::pair<int, std::vector<unsigned int> > > nodes;
+    DIR* dir = opendir(sys_node_dir);
+    if(dir != NULL)
+    {
+        while(struct dirent* entry = readdir(dir))
+        {
+            std::string name = entry->d_name;
+            if(name.compare(0, 4, "node") != 0 || name.size() == 4 || name.find_first_not_of("0123456789", 4) != std::string::npos)
+                continue;
+            std::ifstream file((std::string(sys_node_dir) + "/" + name + "/cpulist").c_str());
+            std::string list;
+            std::vector<unsigned int> cpus, node_usable;
+            if(!std::getline(file, list) || !parse_cpu_list(list, cpus)) continue;
+            for(size_t i = 0; i < cpus.size(); ++i)
+                if(std::find(usable.begin(), usable.end(), cpus[i]) != usable.end()) node_usable.push_back(cpus[i]);
+            //memory-only nodes and nodes outside of the affinity mask run no threads
+            if(!node_usable.empty()) nodes.push_back(std::make_pair(atoi(name.c_str() + 4), node_usable));
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    if(nodes.empty()) nodes.push_back(std::make_pair(0, usable));
+
+    for(size_t node = 0; node < nodes.size(); ++node)
+    {
+        topology.node_cpus.push_back(nodes[node].second);
+        topology_node_ids().push_back(nodes[node].first);
+        for(size_t i = 0; i < nodes[node].second.size(); ++i)
+        {
+            unsigned int cpu = nodes[node].second[i];
+            if(cpu >= topology.cpu_node.size()) topology.cpu_node.resize(cpu + 1, -1);
+            topology.cpu_node[cpu] = node;
+        }
+    }
+    return topology;
+}
+
+const CpuTopology& cpu_topology()
+{
+    static const CpuTopology topology = read_cpu_topology();
+    return topology;
+}
+
+std::vector<ThreadPlacement> place_threads(const CpuTopology& topology, unsigned int num_threads)
+{
+    std::vector<ThreadPlacement> placement(num_threads);
+    unsigned int num_nodes = std::max(1u, topology.num_nodes());
+    for(unsigned int thread = 0; thread < num_threads; ++thread)
+    {
+        ThreadPlacement& place = placement[thread];
+        place.node = thread % num_nodes;
+        if(topology.num_nodes() == 0)
+        {
+            place.cpu = thread;
+            continue;
+        }
+        const std::vector<unsigned int>& cpus = topology.node_cpus[place.node];
+        place.cpu = cpus[(thread / num_nodes) % cpus.size()];
+    }
+    return placement;
+}
+
+bool pin_current_thread(unsigned int cpu)
+{
+#ifdef __linux__
+    if(cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void) cpu;
+    return false;
+#endif
+}
+
+int current_node()
+{
+#ifdef __linux__
+    int cpu = sched_getcpu();
+    if(cpu >= 0) return cpu_topology().node_of(cpu);
+#endif
+    return -1;
+}
+
+int page_node(const void* address)
+{
+#if defined(__linux__) && defined(SYS_move_pages)
+    const CpuTopology& topology = cpu_topology();
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    void* page = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(address) & ~(page_size - 1));
+    int status = -1;
+    //without target nodes, move_pages only reports where the pages are
+    if(syscall(SYS_move_pages, 0, 1UL, &page, NULL, &status, 0) != 0 || status < 0) return -1;
+    const std::vector<int>& node_ids = topology_node_ids();
+    std::vector<int>::const_iterator id = std::find(node_ids.begin(), node_ids.end(), status);
+    return id != node_ids.end() && topology.num_nodes() > 0 ? id - node_ids.begin() : -1;
+#else
+    (void) address;
+    return -1;
+#endif
+}
+
+void print_placement(std::ostream& out, const CpuTopology& topology, const std::vector<ThreadPlacement>& placement)
+{
+    for(unsigned int node = 0; node < std::max(1u, topology.num_nodes()); ++node)
+    {
+        std::vector<unsigned int> cpus;
+        for(size_t thread = 0; thread < placement.size(); ++thread)
+            if(placement[thread].node == node) cpus.push_back(placement[thread].cpu);
+        out << "Node " << (node < topology_node_ids().size() ? topology_node_ids()[node] : 0) << ": " << cpus.size() << " threads";
+        for(size_t i = 0; i < cpus.size(); ++i) out << (i == 0 ? " on cpus " : ",") << cpus[i];
+        out << std::endl;
+    }
+}
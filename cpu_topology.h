@@ -0,0 +1,77 @@
+/**
+ * @file    cpu_topology.h
+ * @brief   Declares the NUMA topology of the node as read from /sys, and the
+ *          placement and pinning of solver threads on it.
+ *
+ * A thread that is pinned before it allocates keeps its buffers on its own
+ * NUMA node: Linux places a page on the node of the thread that first
+ * touches it.  Without /sys (or on other systems) the node is treated as a
+ * single NUMA node holding all CPUs the process may run on.
+ */
+
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+/**
+ * @brief The usable CPUs of every NUMA node.
+ */
+struct CpuTopology
+{
+    std::vector<std::vector<unsigned int> > node_cpus; //per node: its CPUs in the affinity mask of the process
+    std::vector<int> cpu_node; //per CPU id: its node, -1 if it is not usable
+
+    unsigned int num_nodes() const { return node_cpus.size(); }
+    unsigned int num_cpus() const;
+    int node_of(unsigned int cpu) const { return cpu < cpu_node.size() ? cpu_node[cpu] : -1; }
+};
+
+//where a thread runs
+struct ThreadPlacement
+{
+    unsigned int cpu;
+    unsigned int node; //the index into CpuTopology::node_cpus
+};
+
+/**
+ * @brief Parses a kernel CPU list like `0-3,8,10-11`.  Returns false if it is malformed.
+ */
+bool parse_cpu_list(const std::string& list, std::vector<unsigned int>& cpus);
+
+/**
+ * @brief Returns the topology of this node, read from /sys once.
+ */
+const CpuTopology& cpu_topology();
+
+/**
+ * @brief Places `num_threads` threads: round robin over the nodes, so every
+ *        node gets a share of the threads, and over the CPUs of each node.
+ *        With more threads than CPUs, CPUs are shared.
+ */
+std::vector<ThreadPlacement> place_threads(const CpuTopology& topology, unsigned int num_threads);
+
+/**
+ * @brief Restricts the calling thread to the given CPU.  Returns false if that is not possible.
+ */
+bool pin_current_thread(unsigned int cpu);
+
+/**
+ * @brief Returns the node the calling thread currently runs on, -1 if unknown.
+ */
+int current_node();
+
+/**
+ * @brief Returns the node holding the page of the given address, -1 if
+ *        unknown (the page is not mapped yet, or the kernel does not tell).
+ */
+int page_node(const void* address);
+
+/**
+ * @brief Prints the CPUs of the threads of every node, on one line per node.
+ */
+void print_placement(std::ostream& out, const CpuTopology& topology, const std::vector<ThreadPlacement>& placement);
+
+#endif // CPU_TOPOLOGY_H
@@ -0,0 +1,89 @@
+/**
+ * @file    huge_pages.cpp
+ * @brief   Implements the huge page advice for solution buffers.
+ */
+
+#include "huge_pages.h"
+
+#include <stdint.h>
+#include <fstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+struct HugePageMode
+{
+    static bool& enabled()
+    {
+        static bool use_huge_pages = true;
+        return use_huge_pages;
+    }
+};
+
+void set_huge_pages_enabled(bool enabled)
+{
+    HugePageMode::enabled() = enabled;
+}
+
+bool huge_pages_enabled()
+{
+    return HugePageMode::enabled();
+}
+
+bool advise_huge_pages(void* address, size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    //only whole huge pages can be backed by one, the partial pages at both ends keep normal pages
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(address) + huge_page_size - 1) & ~(huge_page_size - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(address) + bytes) & ~(huge_page_size - 1);
+    if(end <= begin) return false;
+    return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE) == 0;
+#else
+    (void) address;
+    (void) bytes;
+    return false;
+#endif
+}
+
+/**
+ * @brief Implements reserve_huge() for both buffer types.
+ */
+template <class Buffer>
+void reserve_huge_buffer(Buffer& buffer, size_t capacity)
+{
+    if(capacity <= buffer.capacity()) return;
+    capacity = std::max(capacity, 2 * buffer.capacity());
+    if(!HugePageMode::enabled() || capacity * sizeof(unsigned int) < huge_page_size)
+    {
+        buffer.reserve(capacity);
+        return;
+    }
+    //the advice has to come before the new pages are first written, so also before the old values are copied
+    Buffer grown;
+    grown.reserve(capacity);
+    advise_huge_pages(grown.data(), grown.capacity() * sizeof(unsigned int));
+    grown.insert(grown.end(), buffer.begin(), buffer.end());
+    buffer.swap(grown);
+}
+
+void reserve_huge(std::vector<unsigned int>& buffer, size_t capacity)
+{
+    reserve_huge_buffer(buffer, capacity);
+}
+
+void reserve_huge(SolutionBuffer& buffer, size_t capacity)
+{
+    reserve_huge_buffer(buffer, capacity);
+}
+
+std::string transparent_huge_page_mode()
+{
+    //the active mode is the one in brackets, e.g. `always [madvise] never`
+    std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string modes;
+    if(!std::getline(file, modes)) return "";
+    size_t open = modes.find('['), close = modes.find(']');
+    return open != std::string::npos && close != std::string::npos && close > open ? modes.substr(open + 1, close - open - 1) : "";
+}
@@ -0,0 +1,51 @@
+/**
+ * @file    huge_pages.h
+ * @brief   Declares the growth of large solution buffers in 2MB huge pages.
+ *
+ * A buffer of hundreds of MB in 4KB pages takes one page fault per page when
+ * it is first written and many TLB misses when it is read.  Buffers grown
+ * with reserve_huge() ask the kernel for transparent huge pages with
+ * madvise(MADV_HUGEPAGE), so the faults and TLB entries are per 2MB.  Where
+ * transparent huge pages are disabled or unavailable the advice fails and
+ * the buffer keeps its normal pages.
+ */
+
+#ifndef HUGE_PAGES_H
+#define HUGE_PAGES_H
+
+#include <vector>
+#include <string>
+#include <stddef.h>
+
+#include "solution_buffer.h"
+
+//the size of a huge page on x86-64 and most aarch64 kernels
+const size_t huge_page_size = 2 * 1024 * 1024;
+
+/**
+ * @brief Enables or disables the huge page advice (enabled by default).
+ */
+void set_huge_pages_enabled(bool enabled);
+bool huge_pages_enabled();
+
+/**
+ * @brief Advises the kernel to back the whole huge pages within [address,
+ *        address + bytes) with huge pages.  Returns false if it refuses.
+ */
+bool advise_huge_pages(void* address, size_t bytes);
+
+/**
+ * @brief Makes room for at least `capacity` values, growing geometrically
+ *        like push_back, and advises huge pages for every new buffer of at
+ *        least one huge page.
+ */
+void reserve_huge(std::vector<unsigned int>& buffer, size_t capacity);
+void reserve_huge(SolutionBuffer& buffer, size_t capacity);
+
+/**
+ * @brief Returns the transparent huge page mode of the kernel (always,
+ *        madvise or never), or an empty string if there are none.
+ */
+std::string transparent_huge_page_mode();
+
+#endif // HUGE_PAGES_H
@@ -0,0 +1,91 @@
+/**
+ * @file    local_nqueens.cpp
+ * @brief   Implements the node-local drivers of the master-worker solver.
+ */
+
+#include "local_nqueens.h"
+
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <thread>
+#include <memory>
+
+#include "master_worker.h"
+#include "thread_transport.h"
+#include "shm_transport.h"
+
+//capacity of each shared memory ring buffer; larger messages stream through it
+const size_t shm_ring_capacity = 1 << 20;
+
+bool parse_local_transport(const std::string& name, Local_Transport& transport)
+{
+    if(name == "threads") transport = thread_transport;
+    else if(name == "procs") transport = process_transport;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief Runs a worker on its own endpoint of the thread transport.
+ */
+void run_thread_worker(ThreadTransportGroup* group, int rank)
+{
+    ThreadTransport transport(*group, rank);
+    worker_main(transport);
+}
+
+bool local_master_main(Local_Transport transport, unsigned int n, unsigned int k, unsigned int p, SolutionSink& output)
+{
+    if(transport == thread_transport)
+    {
+        ThreadTransportGroup group(p);
+        std::vector<std::thread> workers;
+        for(unsigned int rank = 1; rank < p; ++rank) workers.push_back(std::thread(run_thread_worker, &group, rank));
+
+        ThreadTransport master(group, 0);
+        bool complete = master_main(master, n, k, output);
+        for(size_t i = 0; i < workers.size(); ++i) workers[i].join();
+        return complete;
+    }
+
+    //the shared memory must exist before forking, so every worker inherits it
+    ShmTransportGroup group(p, shm_ring_capacity);
+    if(!group.valid())
+    {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    std::vector<pid_t> workers;
+    for(unsigned int rank = 1; rank < p; ++rank)
+    {
+        pid_t pid = fork();
+        if(pid < 0)
+        {
+            perror("fork");
+            exit(EXIT_FAILURE);
+        }
+        if(pid == 0)
+        {
+            ShmTransport worker(group, rank);
+            worker_main(worker);
+            _exit(EXIT_SUCCESS); //skip the parent's atexit handlers and buffered output
+        }
+        workers.push_back(pid);
+    }
+
+    ShmTransport master(group, 0);
+    bool complete = master_main(master, n, k, output);
+    for(size_t i = 0; i < workers.size(); ++i) waitpid(workers[i], NULL, 0);
+    return complete;
+}
+
+bool local_master_main(Local_Transport transport, unsigned int n, unsigned int k, unsigned int p,
+                       std::vector<unsigned int>& solutions)
+{
+    VectorSolutionSink output(solutions);
+    return local_master_main(transport, n, k, p, output);
+}
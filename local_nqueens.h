@@ -0,0 +1,52 @@
+/**
+ * @file    local_nqueens.h
+ * @brief   Declares the drivers that run the master-worker solver within a
+ *          single node, over threads or over forked processes.
+ */
+
+#ifndef LOCAL_NQUEENS_H
+#define LOCAL_NQUEENS_H
+
+#include <vector>
+#include <string>
+
+#include "solution_sink.h"
+
+//the node-local transports the master-worker solver can run on
+enum Local_Transport
+{
+    thread_transport = 0,
+    process_transport = 1
+};
+
+/**
+ * @brief Parses a transport name (`threads` or `procs`).  Returns false if unknown.
+ */
+bool parse_local_transport(const std::string& name, Local_Transport& transport);
+
+/**
+ * @brief Runs the master-worker solver with `p` ranks on this node.
+ *
+ * The calling thread becomes the master (rank 0).  The `p-1` workers are
+ * started as threads connected by lock-free queues, or as forked processes
+ * connected by shared memory ring buffers, and have exited when this
+ * function returns.
+ *
+ * @param transport Which node-local transport to use.
+ * @param n         The size of the nqueens problem.
+ * @param k         The number of levels solved by the master.
+ * @param p         The number of ranks including the master, at least 2.
+ * @param output    Receives all solutions, in the order of the sequential solver.
+ * @returns         false if a worker could not take part (see master_main()).
+ *                  The workers have exited in either case.
+ */
+bool local_master_main(Local_Transport transport, unsigned int n, unsigned int k, unsigned int p, SolutionSink& output);
+
+/**
+ * @brief Runs the master-worker solver with `p` ranks on this node and appends all solutions, concatenated,
+ *        to `solutions`.  Returns false if a worker could not take part.
+ */
+bool local_master_main(Local_Transport transport, unsigned int n, unsigned int k, unsigned int p,
+                       std::vector<unsigned int>& solutions);
+
+#endif // LOCAL_NQUEENS_H
@@ -0,0 +1,72 @@
+/**
+ * @file    lockfree_queue.h
+ * @brief   Implements an unbounded lock-free multi-producer single-consumer queue.
+ */
+
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+/**
+ * @brief Lock-free queue for any number of producer threads and one consumer thread.
+ *
+ * Producers link a new node with a single atomic exchange, so pushes never
+ * wait for each other or for the consumer.  The consumer always owns a stub
+ * node at the tail whose value has already been taken.
+ */
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue()
+    {
+        Node* stub = new Node();
+        head.store(stub, std::memory_order_relaxed);
+        tail = stub;
+    }
+
+    ~MpscQueue()
+    {
+        T value;
+        while(pop(value)) {}
+        delete tail;
+    }
+
+    //may be called from any thread
+    void push(T value)
+    {
+        Node* node = new Node();
+        node->value = std::move(value);
+        Node* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    //must only be called from the consumer thread.  Returns false if the queue is empty
+    bool pop(T& value)
+    {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if(next == nullptr) return false;
+        value = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        Node() : next(nullptr) {}
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    MpscQueue(const MpscQueue&);
+    MpscQueue& operator=(const MpscQueue&);
+
+    std::atomic<Node*> head; //last pushed node, shared by the producers
+    Node* tail; //stub node, owned by the consumer
+};
+
+#endif // LOCKFREE_QUEUE_H
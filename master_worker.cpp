@@ -0,0 +1,469 @@
+/**
+ * @file    master_worker.cpp
+ * @brief   Implements the master-worker nqueens solver on top of a transport.
+ */
+
+#include "master_worker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <iostream>
+#include <stdlib.h>
+#include "nqueens.h"
+#include "reorder_buffer.h"
+#include "prefix_generator.h"
+
+//defines the message types used for sending and recieving in a readable format
+enum Message_Type
+{
+    partial_result_tag = 2,
+    termination_tag = 3,
+    work_request_tag = 4,
+    parameters_tag = 6
+};
+
+//defines which process is the one distributing work
+enum Process_Type
+{
+    master_process = 0
+};
+
+//defines if the worker which is ready for work has a solution or not.
+//sent as the first value of every work request, any solutions follow it in the same message
+enum Ready_Status
+{
+    not_ready = 0,
+    initial_ready = 1,
+    solution_ready = 2,
+    no_solution_ready = 3,
+    parameters_error = 4    //the worker could not read the parameters and takes no work
+};
+
+//the layout of the header in front of the prefix sent to a worker and in front of the solutions it returns
+enum Header_Field
+{
+    task_field = 0,             //work and results: the id of the task, numbered in dispatch order
+    cost_low_field = 1,         //results: nanoseconds spent on the task, low and high 32 bits
+    cost_high_field = 2,
+    work_header_size = 1,       //work: the prefix follows the task id
+    result_header_size = 3      //results: the solutions follow the header, after the ready status
+};
+
+
+// stores all local solutions. copied from nqueens.cpp (because it's defined locally there, not in the header)
+// each worker uses this to store its local solution, the master collects them in a ReorderBuffer.
+// thread local, because the workers of the thread transport share one process, and renamed to keep
+// it apart from the non thread local original
+struct WorkerSolutionStore
+{
+    // store solutions in a static member variable
+    static std::vector<unsigned int>& solutions()
+    {
+        static thread_local std::vector<unsigned int> sols;
+        return sols;
+    }
+    static void add_solution(const std::vector<unsigned int>& sol) { solutions().insert(solutions().end(), sol.begin(), sol.end()); }
+    static void clear_solutions() { solutions().clear(); }
+};
+
+
+//stores the number of workers who currently have work.  Used to gather all solutions once
+//all work has been distributed
+struct ActiveWorkers
+{
+    static unsigned int& active_workers()
+    {
+        static thread_local unsigned int workers;
+        return workers;
+    }
+    static void initialize_workers() { active_workers() = 0; }
+    static void add_worker() { ++active_workers(); }
+    static void remove_worker() { --active_workers(); }
+};
+
+//the transport of the master or worker running on this thread, used from within the nqueens_by_level callbacks
+struct CurrentTransport
+{
+    static Transport*& transport()
+    {
+        static thread_local Transport* current;
+        return current;
+    }
+};
+
+//the master's task numbering and the optional per-task log of the current run
+struct MasterTasks
+{
+    static unsigned int& next_task()
+    {
+        static thread_local unsigned int task_id;
+        return task_id;
+    }
+    static unsigned int& n()
+    {
+        static thread_local unsigned int problem_size;
+        return problem_size;
+    }
+    //puts the results back into task order
+    static ReorderBuffer*& reorder()
+    {
+        static thread_local ReorderBuffer* buffer;
+        return buffer;
+    }
+    //set once a worker reports that it cannot take part: no further tasks are dispatched
+    static bool& failed()
+    {
+        static thread_local bool worker_failed;
+        return worker_failed;
+    }
+    //workers that have reported in and wait for work
+    static std::vector<unsigned int>& idle_workers()
+    {
+        static thread_local std::vector<unsigned int> idle;
+        return idle;
+    }
+    //the general problem being solved, NULL for the plain n-queens problem
+    static const Problem*& problem()
+    {
+        static const Problem* master_problem = NULL;
+        return master_problem;
+    }
+    //the reducer results are merged into, NULL when collecting solutions
+    static Reducer*& reducer()
+    {
+        static Reducer* master_reducer = NULL;
+        return master_reducer;
+    }
+    static bool& logging()
+    {
+        static bool log_tasks = false;
+        return log_tasks;
+    }
+    static TaskLog& log()
+    {
+        static TaskLog task_log;
+        return task_log;
+    }
+    static std::chrono::steady_clock::time_point& start()
+    {
+        static std::chrono::steady_clock::time_point run_start;
+        return run_start;
+    }
+    //microseconds since the start of the run
+    static double now_us()
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start()).count();
+    }
+};
+
+/**
+ * @brief Function which obtains a solution, if availible, from a worker and stores it.  Returns which worker sent the result so more work can be given to it.
+ */
+unsigned int recieve_solution()
+{
+    static thread_local Message message;
+    CurrentTransport::transport()->recv(any_source, message); //pick any ready worker to do the work
+    unsigned int worker_ready = message.data.empty() ? not_ready : message.data[0];
+    const unsigned int* result = message.data.data() + 1; //the result header follows the ready status
+    if(worker_ready == solution_ready && MasterTasks::failed())
+    {
+        //the run is incomplete anyway, the results of the tasks still in flight are dropped
+    }
+    else if(worker_ready == solution_ready && MasterTasks::reducer() != NULL)
+    {
+        //merge the reducer state which follows the result header
+        MasterTasks::reducer()->merge(result + result_header_size, message.data.size() - 1 - result_header_size);
+    }
+    else if(worker_ready == solution_ready) //if the worker has a solution ready to send
+    {
+        //store the solutions which follow the result header, in task order
+        MasterTasks::reorder()->append(result[task_field], result + result_header_size, message.data.data() + message.data.size());
+    }
+    if(worker_ready == parameters_error)
+    {
+        //without this worker the run cannot complete: dispatch nothing more, master_main() reports the failure
+        std::cerr << "[ERROR]: worker " << message.source << " received malformed parameters" << std::endl;
+        MasterTasks::failed() = true;
+    }
+    if(worker_ready == solution_ready || worker_ready == no_solution_ready)
+    {
+        MasterTasks::reorder()->complete(result[task_field]);
+        ActiveWorkers::remove_worker(); //this worker is now finished
+    }
+
+    if(MasterTasks::logging() && (worker_ready == solution_ready || worker_ready == no_solution_ready))
+    {
+        TaskRecord& task = MasterTasks::log().tasks[result[task_field]];
+        task.cost_ns = (static_cast<uint64_t>(result[cost_high_field]) << 32) | result[cost_low_field];
+        //reducing workers do not return their solutions
+        task.num_solutions = MasterTasks::reducer() != NULL ? 0 : (message.data.size() - 1 - result_header_size) / MasterTasks::n();
+        task.result_us = MasterTasks::now_us();
+    }
+
+    return message.source; //return which worker just reported its solution
+}
+
+/**
+ * @brief Sends the problem size, master depth, reducer type and the general problem, if any, from the master to every worker.
+ */
+void send_parameters(Transport& transport, unsigned int n, unsigned int k, Reducer_Type reducer, const Problem* problem)
+{
+    std::vector<unsigned int> parameters(1, n);
+    parameters.push_back(k);
+    parameters.push_back(reducer);
+    if(problem != NULL) problem->serialize(parameters); //follows the fixed parameters
+    for(int current_process = 1; current_process < transport.size(); ++current_process)
+        transport.send(current_process, parameters_tag, parameters);
+}
+
+/**
+ * @brief Receives the problem size, master depth, reducer type and the general problem, if any, on a worker.
+ *        Returns false if the message is truncated or holds no valid problem.
+ */
+bool recieve_parameters(Transport& transport, unsigned int& n, unsigned int& k, Reducer_Type& reducer,
+                        std::unique_ptr<Problem>& problem)
+{
+    Message message;
+    transport.recv(master_process, message);
+    problem.reset();
+    if(message.tag != parameters_tag || message.data.size() < 3 || message.data[2] > symmetry_reducer) return false;
+    n = message.data[0];
+    k = message.data[1];
+    reducer = static_cast<Reducer_Type>(message.data[2]);
+    if(message.data.size() > 3)
+    {
+        problem.reset(new Problem());
+        if(!problem->deserialize(message.data.data() + 3, message.data.size() - 3) || problem->n != n) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief The master's call back function for each found solution.
+ *
+ * This is the callback function for the master process, that is called
+ * from within the nqueens solver, whenever a valid solution of level
+ * `k` is found.
+ *
+ * This function will send the partial solution to a worker which has
+ * completed his previously assigned work. As such this function must
+ * also first receive the solution from the worker before sending out
+ * the new work.  It also keeps receiving while the task is too far ahead
+ * of the oldest unfinished task for the reorder buffer.
+ *
+ * @param solution      The valid solution. This is passed from within the
+ *                      nqueens solver function.
+ */
+void master_solution_func(std::vector<unsigned int>& solution)
+{
+    // receive solutions or work-requests from a worker and then proceed to send this partial solution to that worker.
+    unsigned int task_id = MasterTasks::next_task()++;
+    std::vector<unsigned int>& idle = MasterTasks::idle_workers();
+    while(!MasterTasks::failed() && (idle.empty() || !MasterTasks::reorder()->has_room(task_id)))
+        idle.push_back(recieve_solution());
+    if(MasterTasks::failed()) return; //the remaining partial solutions are skipped
+    unsigned int next_worker = idle.back();
+    idle.pop_back();
+
+    //the task id goes in front of the partial solution
+    static thread_local std::vector<unsigned int> work;
+    work.assign(1, task_id);
+    work.insert(work.end(), solution.begin(), solution.end());
+    CurrentTransport::transport()->send(next_worker, partial_result_tag, work);
+    ActiveWorkers::add_worker(); //this worker is now active
+
+    if(MasterTasks::logging())
+    {
+        TaskRecord task;
+        task.task_id = task_id;
+        task.worker = next_worker;
+        task.cost_ns = 0;
+        task.num_solutions = 0;
+        task.dispatch_us = MasterTasks::now_us();
+        task.result_us = 0;
+        task.prefix = solution;
+        MasterTasks::log().tasks.push_back(task);
+    }
+}
+
+bool master_main(Transport& transport, unsigned int n, unsigned int k, SolutionSink& output) {
+    CurrentTransport::transport() = &transport;
+
+    //send the size and number of levels that the master process will solve to all workers
+    Reducer* reducer = MasterTasks::reducer();
+    const Problem* problem = MasterTasks::problem();
+    send_parameters(transport, n, k, reducer != NULL ? reducer->type() : no_reducer, problem);
+    if(reducer != NULL) reducer->init(n);
+
+    //initialize active workers to 0, this will change as they report in asking for work
+    ActiveWorkers::initialize_workers();
+    MasterTasks::next_task() = 0;
+    MasterTasks::n() = n;
+    MasterTasks::idle_workers().clear();
+    MasterTasks::failed() = false;
+    ReorderBuffer reorder(output, std::max(default_reorder_window, static_cast<size_t>(4 * transport.size())));
+    MasterTasks::reorder() = &reorder;
+    if(MasterTasks::logging())
+    {
+        MasterTasks::log().n = n;
+        MasterTasks::log().k = k;
+        MasterTasks::log().p = transport.size();
+        MasterTasks::log().tasks.clear();
+        MasterTasks::start() = std::chrono::steady_clock::now();
+    }
+
+    // generate all partial solutions (up to level k), on prefix_threads()
+    // threads, and call the master solution function
+    generate_prefixes(problem, n, k, &master_solution_func);
+
+    //get remaining solutions from workers; after a failure too, so that every worker is waiting for the termination
+    while(ActiveWorkers::active_workers() > 0) recieve_solution();
+
+    //tell every process to terminate
+    for(int current_process = 1; current_process < transport.size(); ++current_process)
+        transport.send(current_process, termination_tag, NULL, 0); //tell the workers to stop running
+
+    MasterTasks::reorder() = NULL;
+    CurrentTransport::transport() = NULL;
+    return !MasterTasks::failed();
+}
+
+bool master_main(Transport& transport, unsigned int n, unsigned int k, std::vector<unsigned int>& solutions) {
+    //all combined solutions, in the order of the sequential solver
+    VectorSolutionSink output(solutions);
+    return master_main(transport, n, k, output);
+}
+
+void set_reducer(Reducer* reducer)
+{
+    MasterTasks::reducer() = reducer;
+}
+
+Reducer* active_reducer()
+{
+    return MasterTasks::reducer();
+}
+
+void set_problem(const Problem* problem)
+{
+    MasterTasks::problem() = problem;
+}
+
+const Problem* active_problem()
+{
+    return MasterTasks::problem();
+}
+
+void set_task_logging(bool enabled)
+{
+    MasterTasks::logging() = enabled;
+}
+
+bool task_logging()
+{
+    return MasterTasks::logging();
+}
+
+const TaskLog& last_task_log()
+{
+    return MasterTasks::log();
+}
+
+void release_workers(Transport& transport)
+{
+    //a problem size of 0 tells the workers that no work will follow
+    send_parameters(transport, 0, 0, no_reducer, NULL);
+}
+
+/**
+ * @brief The workers' call back function for each found solution.
+ *
+ * This is the callback function for the worker processes, that is called
+ * from within the nqueens solver, whenever a valid solution is found.
+ *
+ * This function saves the solution into the worker's solution cache.
+ *
+ * @param solution      The valid solution. This is passed from within the
+ *                      nqueens solver function.
+ */
+void worker_solution_func(std::vector<unsigned int>& solution) {
+    WorkerSolutionStore::add_solution(solution); //save the solution into a local cache
+}
+
+//the reducer of the worker running on this thread, used from within its nqueens_by_level callback
+struct WorkerReducer
+{
+    static Reducer*& reducer()
+    {
+        static thread_local Reducer* worker_reducer;
+        return worker_reducer;
+    }
+};
+
+/**
+ * @brief The workers' call back function while reducing: accumulates the solution instead of saving it.
+ */
+void worker_reduce_func(std::vector<unsigned int>& solution) {
+    WorkerReducer::reducer()->accumulate(solution.data());
+}
+
+void worker_main(Transport& transport) {
+    //recieve the problem size and number of levels that the master process solved
+    unsigned int n, k;
+    Reducer_Type reducer_type;
+    std::unique_ptr<Problem> problem;
+    if(!recieve_parameters(transport, n, k, reducer_type, problem))
+    {
+        //searching a partial board would return wrong results without notice, so take no work at all
+        std::cerr << "[ERROR]: worker " << transport.rank() << " received malformed parameters" << std::endl;
+        unsigned int error_status = parameters_error;
+        transport.send(master_process, work_request_tag, &error_status, 1);
+        return;
+    }
+    if(n == 0) return; //the master already knows the result, there is no work
+    std::unique_ptr<Reducer> reducer(create_reducer(reducer_type));
+    WorkerReducer::reducer() = reducer.get();
+
+    //allocate space for partial solution
+    std::vector<unsigned int> pos(n);
+
+    //send initial ready signal to the master
+    unsigned int ready_status = initial_ready;
+    transport.send(master_process, work_request_tag, &ready_status, 1);
+
+    //handle messages from the master until it tells this worker to terminate
+    Message message;
+    while(true)
+    {
+        transport.recv(master_process, message);
+        if(message.tag == termination_tag) break;
+
+        //compute all solutions for given initial configuration.  The ready status and the result header go in
+        //front of the solutions, so the whole reply can be sent straight from the solution cache
+        std::copy(message.data.begin() + work_header_size, message.data.end(), pos.begin());
+        WorkerSolutionStore::clear_solutions();
+        WorkerSolutionStore::solutions().resize(1 + result_header_size);
+        std::chrono::steady_clock::time_point task_start = std::chrono::steady_clock::now();
+        if(reducer)
+        {
+            reducer->init(n);
+            if(problem) problem_by_level(*problem, pos, k, n, &worker_reduce_func);
+            else nqueens_by_level(pos, k, n, &worker_reduce_func);
+        }
+        else if(problem) problem_by_level(*problem, pos, k, n, &worker_solution_func);
+        else nqueens_by_level(pos, k, n, &worker_solution_func);
+        uint64_t cost_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - task_start).count();
+
+        //return all solutions, if any, or the reducer state to the master
+        std::vector<unsigned int>& reply = WorkerSolutionStore::solutions();
+        if(reducer) reducer->serialize(reply);
+        reply[0] = reply.size() > 1 + result_header_size ? solution_ready : no_solution_ready;
+        reply[1 + task_field] = message.data[task_field];
+        reply[1 + cost_low_field] = static_cast<unsigned int>(cost_ns);
+        reply[1 + cost_high_field] = static_cast<unsigned int>(cost_ns >> 32);
+        transport.send(master_process, work_request_tag, reply);
+    }
+    WorkerSolutionStore::clear_solutions();
+    WorkerReducer::reducer() = NULL;
+}
@@ -0,0 +1,100 @@
+/**
+ * @file    master_worker.h
+ * @brief   Declares the master-worker nqueens solver on top of an arbitrary
+ *          transport (see transport.h).  The master is always rank 0.
+ */
+
+#ifndef MASTER_WORKER_H
+#define MASTER_WORKER_H
+
+#include <vector>
+
+#include "transport.h"
+#include "solution_sink.h"
+#include "task_log.h"
+#include "reducer.h"
+#include "problem.h"
+
+/**
+ * @brief   Performs the master's main work over the given transport.
+ *
+ * Generates the partial solutions of the first `k` levels, dispatches each to
+ * an idle worker, collects all results and finally sends the termination
+ * message to all workers.
+ *
+ * @param transport The master's endpoint (rank 0).
+ * @param n         The size of the nqueens problem.
+ * @param k         The number of levels the master process will solve before
+ *                  passing further work to a worker process.
+ * @param output    Receives all solutions, in the order of the sequential solver.
+ * @returns         false if a worker could not take part, e.g. because it
+ *                  received malformed parameters.  The run stops early then
+ *                  and `output` holds an incomplete result, but all workers
+ *                  have been terminated.
+ */
+bool master_main(Transport& transport, unsigned int n, unsigned int k, SolutionSink& output);
+
+/**
+ * @brief   Performs the master's main work and appends all solutions, concatenated, to `solutions`.
+ *          Returns false if a worker could not take part, like the sink variant.
+ */
+bool master_main(Transport& transport, unsigned int n, unsigned int k, std::vector<unsigned int>& solutions);
+
+/**
+ * @brief   Performs a worker's main work over the given transport.
+ *
+ * Completes partial solutions received from the master until the
+ * termination message is received.
+ */
+void worker_main(Transport& transport);
+
+/**
+ * @brief   Releases all workers of the transport without giving them any work.
+ */
+void release_workers(Transport& transport);
+
+/**
+ * @brief   Makes master_main() reduce the solutions instead of collecting them.
+ *
+ * While a reducer is set, every worker accumulates the solutions of each task
+ * into a reducer of the same type and returns only its serialized state,
+ * which the master merges into `reducer`.  The solution sink receives
+ * nothing.  Pass NULL to collect solutions again.
+ */
+void set_reducer(Reducer* reducer);
+
+/**
+ * @brief   Returns the reducer set by set_reducer(), or NULL.
+ */
+Reducer* active_reducer();
+
+/**
+ * @brief   Makes master_main() solve a general problem (see problem.h) instead of the plain n-queens problem.
+ *
+ * The problem is sent to the workers with the other parameters, and both
+ * sides use problem_by_level() in place of nqueens_by_level().  `n` must be
+ * the problem's.  Pass NULL to solve the plain problem again.
+ */
+void set_problem(const Problem* problem);
+
+/**
+ * @brief   Returns the problem set by set_problem(), or NULL.
+ */
+const Problem* active_problem();
+
+/**
+ * @brief   Enables or disables recording a TaskRecord for every task dispatched by master_main().
+ */
+void set_task_logging(bool enabled);
+
+/**
+ * @brief   Returns whether task logging is enabled.
+ */
+bool task_logging();
+
+/**
+ * @brief   Returns the task log of the last master_main() run with logging enabled.
+ */
+const TaskLog& last_task_log();
+
+#endif // MASTER_WORKER_H
@@ -0,0 +1,172 @@
+/**
+ * @file    merge_main.cpp
+ * @brief   Implements the tool that combines the solution files written by
+ *          `./nqueens -s i/N -w <file>` into the final count or into a single
+ *          solution file in lexicographic order.
+ *
+ * Every shard file is sorted and the shards hold disjoint sets of prefixes,
+ * so the merge copies whole runs: the run of the shard with the smallest
+ * next solution extends up to the next solution of any other shard, and its
+ * end is found by binary search in the memory mapped file.
+ */
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "nqueens_cache.h"
+#include "nqueens_shard.h"
+
+
+/**
+ * Prints the usage of the program.
+ */
+void print_usage() {
+    std::cerr << "Usage: ./nqueens-merge [options] <shard file>..." << std::endl;
+    std::cerr << "      Required arguments:" << std::endl;
+    std::cerr << "          <shard file>  The solution files of all shards, each with its" << std::endl;
+    std::cerr << "                        manifest <shard file>.shard next to it." << std::endl;
+    std::cerr << "      Optional arguments:" << std::endl;
+    std::cerr << "          -o <file>     Write all solutions in lexicographic order to <file>." << std::endl;
+    std::cerr << "                        Without -o only the counts are added up." << std::endl;
+    std::cerr << "      Example:" << std::endl;
+    std::cerr << "          for i in 0 1 2 3; do ./nqueens-threads -s $i/4 -w s$i.bin 14 3; done" << std::endl;
+    std::cerr << "          ./nqueens-merge -o all.bin s0.bin s1.bin s2.bin s3.bin" << std::endl;
+}
+
+/**
+ * @brief Returns whether solution `a` is lexicographically smaller than solution `b`.
+ */
+bool solution_less(const unsigned int* a, const unsigned int* b, unsigned int n)
+{
+    return std::lexicographical_compare(a, a + n, b, b + n);
+}
+
+/**
+ * @brief Returns the index of the first solution in [begin, end) of the file that is not smaller than `bound`.
+ */
+size_t lower_bound_solution(const MappedSolutionFile& file, unsigned int n, size_t begin, size_t end, const unsigned int* bound)
+{
+    const unsigned int* sols = file.solutions();
+    while(begin < end)
+    {
+        size_t middle = begin + (end - begin) / 2;
+        if(solution_less(sols + middle * n, bound, n)) begin = middle + 1;
+        else end = middle;
+    }
+    return begin;
+}
+
+int main(int argc, char *argv[]) {
+    std::string opt_output_file;
+
+    // forget about first argument (which is the executable's name)
+    argc--;
+    argv++;
+
+    // parse optional parameters
+    while (argc > 0 && argv[0][0] == '-') {
+        char option = argv[0][1];
+        switch (option) {
+            case 'o':
+                if (argc < 2) {
+                    print_usage();
+                    exit(EXIT_FAILURE);
+                }
+                opt_output_file = argv[1];
+                argv++;
+                argc--;
+                break;
+            default:
+                print_usage();
+                exit(EXIT_FAILURE);
+        }
+        argv++;
+        argc--;
+    }
+    if (argc < 1) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    // check that the files are exactly the shards of one run
+    size_t num_shards = argc;
+    std::vector<MappedSolutionFile> files(num_shards);
+    std::vector<ShardManifest> manifests(num_shards);
+    std::vector<bool> seen(num_shards, false);
+    for (size_t i = 0; i < num_shards; ++i) {
+        std::string path = argv[i];
+        if (!read_shard_manifest(shard_manifest_path(path), manifests[i])) {
+            std::cerr << "[ERROR]: Could not read the shard manifest " << shard_manifest_path(path) << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (!files[i].open(path) || files[i].header().n != manifests[i].n || files[i].header().mode != all_mode) {
+            std::cerr << "[ERROR]: " << path << " is not a solution file of a shard" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        const ShardManifest& m = manifests[i];
+        if (m.shard.count != num_shards) {
+            std::cerr << "[ERROR]: " << path << " is shard " << m.shard.index << "/" << m.shard.count << ", but "
+                      << num_shards << " files were given" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (m.n != manifests[0].n || m.k != manifests[0].k || seen[m.shard.index]) {
+            std::cerr << "[ERROR]: " << path << " (shard " << m.shard.index << "/" << m.shard.count << ", n=" << m.n
+                      << ", k=" << m.k << ") does not belong to the same run as the other " << num_shards - 1 << " shards" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        seen[m.shard.index] = true;
+    }
+
+    unsigned int n = manifests[0].n;
+    unsigned long long count = 0;
+    for (size_t i = 0; i < num_shards; ++i)
+        count += files[i].header().count;
+
+    if (!opt_output_file.empty()) {
+        SolutionFileWriter writer;
+        if (!writer.open(opt_output_file, n, all_mode)) {
+            std::cerr << "[ERROR]: Could not write " << opt_output_file << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        // next solution to copy of every shard
+        std::vector<size_t> next(num_shards, 0);
+        std::vector<size_t> num_sols(num_shards);
+        for (size_t i = 0; i < num_shards; ++i)
+            num_sols[i] = files[i].size() / n;
+        bool ok = true;
+        while (ok) {
+            // find the shards with the smallest and the second smallest next solution
+            size_t first = num_shards, second = num_shards;
+            for (size_t i = 0; i < num_shards; ++i) {
+                if (next[i] == num_sols[i])
+                    continue;
+                const unsigned int* head = files[i].solutions() + next[i] * n;
+                if (first == num_shards || solution_less(head, files[first].solutions() + next[first] * n, n)) {
+                    second = first;
+                    first = i;
+                } else if (second == num_shards || solution_less(head, files[second].solutions() + next[second] * n, n)) {
+                    second = i;
+                }
+            }
+            if (first == num_shards)
+                break;
+            // copy the run of the first shard that comes before the next solution of any other shard
+            size_t end = num_sols[first];
+            if (second != num_shards)
+                end = lower_bound_solution(files[first], n, next[first] + 1, end, files[second].solutions() + next[second] * n);
+            ok = writer.append(files[first].solutions() + next[first] * n, (end - next[first]) * n);
+            next[first] = end;
+        }
+        if (!ok || !writer.commit(count)) {
+            std::cerr << "[ERROR]: Could not write " << opt_output_file << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    std::cerr << "Number of solutions found: " << count << std::endl;
+    return 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file    mpi_binding.cpp
+ * @brief   Implements the binding of MPI ranks to cores.
+ */
+
+#include "mpi_binding.h"
+
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+
+#include "cpu_topology.h"
+
+//the fields of a RankPlacement, as sent to rank 0
+const int placement_fields = 7;
+
+/**
+ * @brief Orders the CPUs of the node round robin over its NUMA nodes, so
+ *        that consecutive ranks land on different NUMA nodes.
+ */
+std::vector<unsigned int> spread_cpus(const CpuTopology& topology)
+{
+    std::vector<unsigned int> order;
+    for(size_t i = 0; order.size() < topology.num_cpus(); ++i)
+    {
+        for(size_t node = 0; node < topology.num_nodes(); ++node)
+            if(i < topology.node_cpus[node].size()) order.push_back(topology.node_cpus[node][i]);
+    }
+    return order;
+}
+
+std::vector<RankPlacement> bind_ranks(MPI_Comm comm)
+{
+    int rank, size, local_rank, local_size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, &local_rank);
+    MPI_Comm_size(node_comm, &local_size);
+
+    //the nodes are numbered by their lowest rank, which is local rank 0 of the node
+    MPI_Comm leaders;
+    MPI_Comm_split(comm, local_rank == 0 ? 0 : MPI_UNDEFINED, rank, &leaders);
+    int node = 0;
+    if(local_rank == 0)
+    {
+        MPI_Comm_rank(leaders, &node);
+        MPI_Comm_free(&leaders);
+    }
+    MPI_Bcast(&node, 1, MPI_INT, 0, node_comm);
+    int lowest_rank = rank;
+    MPI_Bcast(&lowest_rank, 1, MPI_INT, 0, node_comm);
+    bool master_node = lowest_rank == 0;
+
+    //rank 0 is local rank 0 of its node and keeps the first CPU to itself
+    const CpuTopology& topology = cpu_topology();
+    std::vector<unsigned int> cpus = spread_cpus(topology);
+    size_t slot;
+    if(master_node && cpus.size() > 1) slot = local_rank == 0 ? 0 : 1 + (local_rank - 1) % (cpus.size() - 1);
+    else slot = local_rank % cpus.size();
+
+    RankPlacement place;
+    place.rank = rank;
+    place.node = node;
+    place.local_rank = local_rank;
+    place.cpu = pin_current_thread(cpus[slot]) ? (int) cpus[slot] : -1;
+    place.numa_node = place.cpu >= 0 ? topology.node_of(place.cpu) : -1;
+    place.kept = cpus.size() == 1 && local_size > 1;
+
+    //a CPU is shared if another rank of the node is bound to it as well
+    std::vector<int> node_cpus(local_size);
+    MPI_Allgather(&place.cpu, 1, MPI_INT, node_cpus.data(), 1, MPI_INT, node_comm);
+    place.shared = place.cpu >= 0 && std::count(node_cpus.begin(), node_cpus.end(), place.cpu) > 1;
+    MPI_Comm_free(&node_comm);
+
+    int fields[placement_fields] = {place.rank, place.node, place.local_rank, place.cpu, place.numa_node, place.shared, place.kept};
+    std::vector<int> all_fields(rank == 0 ? size * placement_fields : 0);
+    MPI_Gather(fields, placement_fields, MPI_INT, all_fields.data(), placement_fields, MPI_INT, 0, comm);
+    std::vector<RankPlacement> placement(all_fields.size() / placement_fields);
+    for(size_t i = 0; i < placement.size(); ++i)
+    {
+        const int* f = &all_fields[i * placement_fields];
+        RankPlacement& p = placement[i];
+        p.rank = f[0];
+        p.node = f[1];
+        p.local_rank = f[2];
+        p.cpu = f[3];
+        p.numa_node = f[4];
+        p.shared = f[5] != 0;
+        p.kept = f[6] != 0;
+    }
+    return placement;
+}
+
+void print_rank_layout(std::ostream& out, const std::vector<RankPlacement>& placement, const std::vector<std::string>& hosts)
+{
+    size_t shared = 0;
+    for(size_t node = 0; node < hosts.size(); ++node)
+    {
+        out << "Node " << node << " (" << hosts[node] << "):";
+        bool first = true;
+        for(size_t i = 0; i < placement.size(); ++i)
+        {
+            const RankPlacement& p = placement[i];
+            if(p.node != (int) node) continue;
+            out << (first ? " " : ", ") << "rank " << p.rank << (p.rank == 0 ? " (master)" : "");
+            if(p.cpu < 0) out << " unbound";
+            else out << " on cpu " << p.cpu << " [numa " << p.numa_node << "]";
+            if(p.kept) out << " (kept)";
+            first = false;
+            shared += p.shared;
+        }
+        out << std::endl;
+    }
+    if(shared > 0)
+        out << "[WARNING]: " << shared << " ranks share their cpu with another rank; start fewer ranks per node "
+            << "or pass --bind-to none to mpirun" << std::endl;
+}
+
+void bind_and_report_ranks(MPI_Comm comm)
+{
+    std::vector<RankPlacement> placement = bind_ranks(comm);
+
+    //the processor name of every rank, of which rank 0 prints one per node
+    int rank, size, length;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    char name[MPI_MAX_PROCESSOR_NAME];
+    memset(name, 0, sizeof(name));
+    MPI_Get_processor_name(name, &length);
+    std::vector<char> names(rank == 0 ? size * MPI_MAX_PROCESSOR_NAME : 0);
+    MPI_Gather(name, MPI_MAX_PROCESSOR_NAME, MPI_CHAR, names.data(), MPI_MAX_PROCESSOR_NAME, MPI_CHAR, 0, comm);
+    if(rank != 0) return;
+
+    std::vector<std::string> hosts;
+    for(size_t i = 0; i < placement.size(); ++i)
+    {
+        if((size_t) placement[i].node >= hosts.size()) hosts.resize(placement[i].node + 1);
+        if(placement[i].local_rank == 0) hosts[placement[i].node] = &names[i * MPI_MAX_PROCESSOR_NAME];
+    }
+    print_rank_layout(std::cerr, placement, hosts);
+}
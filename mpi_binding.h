@@ -0,0 +1,54 @@
+/**
+ * @file    mpi_binding.h
+ * @brief   Declares the binding of MPI ranks to cores of their node.
+ *
+ * The ranks of every node are found with MPI_Comm_split_type and spread over
+ * the node's cores, round robin over its NUMA nodes (see cpu_topology.h).
+ * The master spins on its messages, so it gets a core of its own: the
+ * workers of its node share the remaining cores.
+ */
+
+#ifndef MPI_BINDING_H
+#define MPI_BINDING_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <mpi.h>
+
+//where one rank runs
+struct RankPlacement
+{
+    int rank;
+    int node;           //the index of its node, in the order of the lowest rank on each node
+    int local_rank;     //its rank among the ranks of its node
+    int cpu;            //the CPU it is bound to, -1 if binding failed
+    int numa_node;      //the NUMA node of the CPU, -1 if unknown
+    bool shared;        //other ranks of the node are bound to the same CPU
+    bool kept;          //the rank was already bound to a single CPU (e.g. by mpirun) and keeps it
+};
+
+/**
+ * @brief Binds every rank of `comm` to a CPU of its node.  Collective.
+ *
+ * A rank whose affinity mask already holds a single CPU keeps it.  The
+ * others pick from the CPUs in their affinity mask, which mpirun must leave
+ * unrestricted (e.g. `--bind-to none`).
+ *
+ * @returns on rank 0 the placement of every rank, ordered by rank; empty on the other ranks.
+ */
+std::vector<RankPlacement> bind_ranks(MPI_Comm comm);
+
+/**
+ * @brief Prints the placement returned by bind_ranks(): one line per node with the CPUs of its ranks.
+ *
+ * @param hosts  The processor name of every node.
+ */
+void print_rank_layout(std::ostream& out, const std::vector<RankPlacement>& placement, const std::vector<std::string>& hosts);
+
+/**
+ * @brief Binds all ranks and prints the layout on rank 0.  Collective.
+ */
+void bind_and_report_ranks(MPI_Comm comm);
+
+#endif // MPI_BINDING_H
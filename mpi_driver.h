@@ -0,0 +1,61 @@
+/**
+ * @file    mpi_driver.h
+ * @brief   Declares the entry points of the MPI solver beyond the assignment's
+ *          interface in mpi_nqueens.h, which stays as it was handed out:
+ *          streaming output, count estimates, early release of the workers
+ *          and the run-time switches of main().
+ */
+
+#ifndef MPI_DRIVER_H
+#define MPI_DRIVER_H
+
+#include "mpi_nqueens.h"
+#include "solution_sink.h"
+#include "count_estimator.h"
+
+/**
+ * @brief   Performs the master's main work, passing all solutions to `output`
+ *          in the order of the sequential solver instead of returning them.
+ *
+ * Returns false if a worker could not take part (see master_worker.h).  The
+ * workers have been terminated then, and the caller should MPI_Abort().
+ */
+bool master_main(unsigned int n, unsigned int k, SolutionSink& output);
+
+/**
+ * @brief   Estimates the number of solutions with `num_probes` Monte Carlo
+ *          probes (see count_estimator.h), split between all ranks.
+ *
+ * The probes run in rounds; after every round the ranks sum their statistics
+ * with MPI_Allreduce and the master prints the estimate so far to stderr.
+ * The workers take part from within worker_main().
+ */
+EstimateStats estimate_master_main(unsigned int n, uint64_t seed, uint64_t num_probes);
+
+/**
+ * @brief   Releases the worker processes without giving them any work.
+ *
+ * The master calls this instead of master_main() when the result is already
+ * known, e.g. from the result cache.  worker_main() then returns immediately.
+ */
+void release_workers();
+
+/**
+ * @brief   Enables or disables the shared memory variant of the solver.
+ *
+ * By default, master_main() uses the shared memory variant (a shared task
+ * queue and result ring buffers in an MPI-3 shared window) whenever all
+ * ranks run on the same node, and MPI messages otherwise.
+ */
+void set_shared_memory_enabled(bool enabled);
+
+/**
+ * @brief   Enables or disables binding the ranks to cores.
+ *
+ * If enabled, master_main() and estimate_master_main() first bind every rank
+ * to a core of its node, with the master on a core of its own, and print the
+ * layout (see mpi_binding.h).
+ */
+void set_rank_binding(bool enabled);
+
+#endif // MPI_DRIVER_H
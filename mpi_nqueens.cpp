@@ -11,135 +11,68 @@
  *********************************************************************/
 
 #include "mpi_nqueens.h"
+#include "mpi_driver.h"
 
 #include <mpi.h>
 #include <vector>
-#include "nqueens.h"
-
-//defines the message types used for MPI send and recieve in a readable format
-enum Message_Type
-{
-    result_tag = 1,
-    partial_result_tag = 2,
-    termination_tag = 3,
-    work_request_tag = 4,
-    solution_recieved_tag = 5
-};
-
-//defines which process is the one distributing work
-enum Process_Type
+#include <iostream>
+#include <algorithm>
+#include "master_worker.h"
+#include "mpi_transport.h"
+#include "mpi_shm_nqueens.h"
+#include "mpi_binding.h"
+
+//defines which variant of the solver all ranks run, decided by the master
+enum Driver_Type
 {
-    master_process = 0
+    message_driver = 0,
+    shared_memory_driver = 1,
+    estimate_driver = 2
 };
 
-//defines if the worker which is ready for work has a solution or not
-enum Ready_Status
+//whether the shared memory variant may be used when all ranks share one node
+struct SharedMemoryMode
 {
-    not_ready = 0,
-    initial_ready = 1,
-    solution_ready = 2,
-    no_solution_ready = 3
-};
-
-//tells whether the partial solution has been recieved by the worker or not
-enum Recieved_Status
-{
-    partial_solution_not_recieved = 0,
-    partial_solution_recieved = 1
-};
-
-//tells the worker if it should keep looking for work or terminate
-enum Running_status
-{
-    terminate = 0,
-    working = 1
-};
-
-
-// stores all local solutions. copied from nqueens.cpp (because it's defined locally there, not in the header)
-// each worker uses this to store its local solution and the master uses it to collocate all solutions
-struct SolutionStore 
-{
-    // store solutions in a static member variable
-    static std::vector<unsigned int>& solutions() 
+    static bool& enabled()
     {
-        static std::vector<unsigned int> sols;
-        return sols;
+        static bool use_shared_memory = true;
+        return use_shared_memory;
     }
-    static void add_solution(const std::vector<unsigned int>& sol) { solutions().insert(solutions().end(), sol.begin(), sol.end()); }
-    static void clear_solutions() { solutions().clear(); }
 };
 
-
-//stores the number of workers who currently have work.  Used to gather all solutions once
-//all work has been distributed
-struct ActiveWorkers
+//whether the ranks are bound to cores before a run
+struct RankBinding
 {
-    static unsigned int& active_workers()
+    static bool& enabled()
     {
-        static unsigned int workers;
-        return workers;
+        static bool bind_ranks = false;
+        return bind_ranks;
     }
-    static void initialize_workers() { active_workers() = 0; }
-    static void add_worker() { ++active_workers(); }
-    static void remove_worker() { --active_workers(); }
 };
 
 /**
- * @brief Function which obtains a solution, if availible, from a worker and stores it.  Returns which worker sent the result so more work can be given to it.
+ * @brief Sends the driver type and problem from the master to all ranks and returns the driver type.
+ *
+ * If the master asks for it with `bind`, all ranks are then bound to cores in one collective step.
  */
-unsigned int recieve_solution()
+unsigned int distribute_driver(unsigned int driver, unsigned int& n, unsigned int& k, bool bind)
 {
-    unsigned int worker_ready = not_ready;
-    MPI_Status ready_status, result_status;
-    MPI_Recv(&worker_ready, 1, MPI_UNSIGNED, MPI_ANY_SOURCE, work_request_tag, MPI_COMM_WORLD, &ready_status); //pick any ready worker to do the work
-    unsigned int next_worker = ready_status.MPI_SOURCE;
-    if(worker_ready == solution_ready) //if the worker has a solution ready to send
-    {
-        //get the size of the solution to recieve and allocate solution vector
-        int solution_size = 0;
-        MPI_Probe(next_worker, result_tag, MPI_COMM_WORLD, &result_status);
-        MPI_Get_count(&result_status, MPI_UNSIGNED, &solution_size);
-        std::vector<unsigned int> recieved_solution(solution_size);
-
-        //recieve and store the solutions
-        MPI_Recv(&recieved_solution[0], solution_size, MPI_UNSIGNED, next_worker, result_tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE); 
-        SolutionStore::add_solution(recieved_solution); 
-
-        ActiveWorkers::remove_worker(); //this worker is now finished
-    }
-    if(worker_ready == no_solution_ready) ActiveWorkers::remove_worker(); //the worker found no solutions, this worker is now finished
-
-    return next_worker; //return which worker just reported its solution
+    unsigned int parameters[4] = {driver, n, k, bind};
+    MPI_Bcast(parameters, 4, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    n = parameters[1];
+    k = parameters[2];
+    if(parameters[3]) bind_and_report_ranks(MPI_COMM_WORLD);
+    return parameters[0];
 }
 
-void distribute_parameters(unsigned int& n, unsigned int& k)
+void set_shared_memory_enabled(bool enabled)
 {
-    MPI_Bcast(&n, 1, MPI_UNSIGNED, master_process, MPI_COMM_WORLD); // send the total size of the nqueens problem to each worker
-    MPI_Bcast(&k, 1, MPI_UNSIGNED, master_process, MPI_COMM_WORLD); // send the number of levels that the master will compute to each worker
+    SharedMemoryMode::enabled() = enabled;
 }
 
-/**
- * @brief The master's call back function for each found solution.
- *
- * This is the callback function for the master process, that is called
- * from within the nqueens solver, whenever a valid solution of level
- * `k` is found.
- *
- * This function will send the partial solution to a worker which has
- * completed his previously assigned work. As such this function must
- * also first receive the solution from the worker before sending out
- * the new work.
- *
- * @param solution      The valid solution. This is passed from within the
- *                      nqueens solver function.
- */
-void master_solution_func(std::vector<unsigned int>& solution) 
+void set_rank_binding(bool enabled)
 {
-    // receive solutions or work-requests from a worker and then proceed to send this partial solution to that worker.
-    unsigned int next_worker = recieve_solution();
-    MPI_Send(&solution[0], solution.size(), MPI_UNSIGNED, next_worker, partial_result_tag, MPI_COMM_WORLD);
-    ActiveWorkers::add_worker(); //this worker is now active
+    RankBinding::enabled() = enabled;
 }
 
 /**
@@ -151,53 +84,72 @@ void master_solution_func(std::vector<unsigned int>& solution)
  * After all work has been dispatched, this function will send the termination
  * message to all worker processes, receive any remaining results, and then return.
  *
+ * The master-worker protocol itself is implemented in master_worker.cpp,
+ * here it runs over MPI_COMM_WORLD.  If all ranks run on the same node, the
+ * shared memory variant of mpi_shm_nqueens.cpp is used instead, unless
+ * tasks are logged or solutions are reduced.
+ *
  * @param n     The size of the nqueens problem.
  * @param k     The number of levels the master process will solve before
  *              passing further work to a worker process.
  */
 std::vector<unsigned int> master_main(unsigned int n, unsigned int k) {
-    //send the size and number of levels that the master process will solve to all workers
-    distribute_parameters(n, k);
-
-    //initialize active workers to 0, this will change as they report in asking for work
-    ActiveWorkers::initialize_workers();
-
-    // allocate the vector for the solution permutations
-    std::vector<unsigned int> pos(n);
-
-    // generate all partial solutions (up to level k) and call the
-    // master solution function
-    nqueens_by_level(pos, 0, k, &master_solution_func);
-
-    //get remaining solutions from workers
-    while(ActiveWorkers::active_workers() > 0) recieve_solution();
-
-    //tell every process to terminate
-    unsigned int keep_running = terminate;
-    int number_of_processes;
-    MPI_Comm_size(MPI_COMM_WORLD, &number_of_processes);
-    for(int current_process = 1; current_process < number_of_processes; ++current_process)
-        MPI_Send(&keep_running, 1, MPI_UNSIGNED, current_process, termination_tag, MPI_COMM_WORLD); //tell the workers to stop running
-
-    //return all combined solutions
-    std::vector<unsigned int> allsolutions = SolutionStore::solutions();
-    SolutionStore::clear_solutions();
+    std::vector<unsigned int> allsolutions;
+    VectorSolutionSink output(allsolutions);
+    //this interface cannot report an incomplete run
+    if (!master_main(n, k, output))
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
     return allsolutions;
 }
 
+bool master_main(unsigned int n, unsigned int k, SolutionSink& output) {
+    //every rank takes part in the node check, so the workers need not know whether it is enabled
+    bool single_node = ranks_share_node(MPI_COMM_WORLD);
+    //the task log, the reducers and the general problems need the per task messages of the message based variant
+    if(SharedMemoryMode::enabled() && single_node && !task_logging() && active_reducer() == NULL && active_problem() == NULL)
+    {
+        distribute_driver(shared_memory_driver, n, k, RankBinding::enabled());
+        shm_master_main(n, k, output);
+        return true;
+    }
+    distribute_driver(message_driver, n, k, RankBinding::enabled());
+    MpiTransport transport(MPI_COMM_WORLD);
+    return master_main(transport, n, k, output);
+}
+
 /**
- * @brief The workers' call back function for each found solution.
- *
- * This is the callback function for the worker processes, that is called
- * from within the nqueens solver, whenever a valid solution is found.
- *
- * This function saves the solution into the worker's solution cache.
- *
- * @param solution      The valid solution. This is passed from within the
- *                      nqueens solver function.
+ * @brief Runs this rank's share of every round of probes, see estimate_master_main().
  */
-void worker_solution_func(std::vector<unsigned int>& solution) {
-    SolutionStore::add_solution(solution); //save the solution into a local cache
+EstimateStats estimate_rounds(unsigned int n, uint64_t seed, uint64_t num_probes)
+{
+    int p, rank;
+    MPI_Comm_size(MPI_COMM_WORLD, &p);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    EstimateStats total;
+    for(uint64_t round_start = 0; round_start < num_probes; round_start += estimate_round_probes)
+    {
+        //the probes of a round are numbered consecutively and split into one contiguous slice per rank
+        uint64_t round_probes = std::min(estimate_round_probes, num_probes - round_start);
+        uint64_t first = round_probes * rank / p, last = round_probes * (rank + 1) / p;
+        EstimateStats local = run_probes(n, seed, round_start + first, last - first);
+        EstimateStats round;
+        //the three sums are consecutive doubles
+        MPI_Allreduce(&local.probes, &round.probes, 3, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+        total.merge(round);
+        if(rank == 0) print_estimate(std::cerr, total);
+    }
+    return total;
+}
+
+EstimateStats estimate_master_main(unsigned int n, uint64_t seed, uint64_t num_probes)
+{
+    //matches the node check at the start of worker_main()
+    ranks_share_node(MPI_COMM_WORLD);
+    unsigned int k = 0;
+    distribute_driver(estimate_driver, n, k, RankBinding::enabled());
+    uint64_t parameters[2] = {seed, num_probes};
+    MPI_Bcast(parameters, 2, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+    return estimate_rounds(n, seed, num_probes);
 }
 
 /**
@@ -212,55 +164,31 @@ void worker_solution_func(std::vector<unsigned int>& solution) {
  * new work), then this function will return.
  */
 void worker_main() {
-    //recieve the problem size and number of levels that the master process solved
-    unsigned int n, k;
-    distribute_parameters(n, k);
-
-    //allocate space for partial solution
-    std::vector<unsigned int> pos(n);
-
-    //send initial ready signal to the master
-    unsigned int ready_status = initial_ready;
-    MPI_Send(&ready_status, 1, MPI_UNSIGNED, master_process, work_request_tag, MPI_COMM_WORLD);
-
-    //set up termination condition.  When the master sends a message telling the process to terminate, computation will end upon completion of the current loop
-    unsigned int keep_working = working;
-    MPI_Request termination_request;
-    MPI_Irecv(&keep_working, 1, MPI_UNSIGNED, master_process, termination_tag, MPI_COMM_WORLD, &termination_request);
-
-    //prepare to recieve partially completed solution
-    MPI_Status recieve_status;
-    MPI_Request work_request;
-    MPI_Irecv(&pos[0], n, MPI_UNSIGNED, master_process, partial_result_tag, MPI_COMM_WORLD, &work_request);
-    while(keep_working == working)
+    ranks_share_node(MPI_COMM_WORLD);
+    unsigned int n = 0, k = 0;
+    unsigned int driver = distribute_driver(message_driver, n, k, false);
+    if(driver == shared_memory_driver)
     {
-        int recieved_flag = partial_solution_not_recieved;
-        MPI_Test(&work_request, &recieved_flag, &recieve_status); //test to see if there is any new work from the master
-        if(recieved_flag == partial_solution_recieved) //if there is work, do it, otherwise keep waiting, will terminate if the termination request is recieved
-        {
-            //compute all solutions for given initial configuration
-            nqueens_by_level(pos, k, n, &worker_solution_func);
-            std::vector<unsigned int> allsolutions = SolutionStore::solutions();
-            SolutionStore::clear_solutions();
-
-            //return all solutions, if any, to the master thread
-            if(!allsolutions.empty())
-            {
-                ready_status = solution_ready;
-                MPI_Send(&ready_status, 1, MPI_UNSIGNED, master_process, work_request_tag, MPI_COMM_WORLD);
-                MPI_Send(&allsolutions[0], allsolutions.size(), MPI_UNSIGNED, master_process, result_tag, MPI_COMM_WORLD);
-            }
-            else
-            {
-                ready_status = no_solution_ready;
-                MPI_Send(&ready_status, 1, MPI_UNSIGNED, master_process, work_request_tag, MPI_COMM_WORLD);
-            }
-
-            //prepare to recieve the next unit of work from the master
-            MPI_Irecv(&pos[0], n, MPI_UNSIGNED, master_process, partial_result_tag, MPI_COMM_WORLD, &work_request);
-        }
+        shm_worker_main(n, k);
+        return;
+    }
+    if(driver == estimate_driver)
+    {
+        uint64_t parameters[2];
+        MPI_Bcast(parameters, 2, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+        estimate_rounds(n, parameters[0], parameters[1]);
+        return;
     }
-    MPI_Request_free(&work_request); //free the request for more work - none is coming
+    MpiTransport transport(MPI_COMM_WORLD);
+    worker_main(transport);
 }
 
-
+void release_workers()
+{
+    ranks_share_node(MPI_COMM_WORLD);
+    unsigned int n = 0, k = 0;
+    //nothing runs on the workers, so they are not bound
+    distribute_driver(message_driver, n, k, false);
+    MpiTransport transport(MPI_COMM_WORLD);
+    release_workers(transport);
+}
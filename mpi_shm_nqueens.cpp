@@ -0,0 +1,401 @@
+/**
+ * @file    mpi_shm_nqueens.cpp
+ * @brief   Implements the shared memory variant of the parallel solver.
+ */
+
+#include "mpi_shm_nqueens.h"
+
+#include <atomic>
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <stdint.h>
+
+#include "nqueens.h"
+#include "shm_ring.h"
+#include "reorder_buffer.h"
+#include "prefix_generator.h"
+
+//number of partial solutions the shared task queue can hold
+const uint64_t shm_task_capacity = 4096;
+//capacity of each worker's result ring buffer
+const uint64_t shm_result_capacity = 1 << 20;
+//set in the task field of the header of a task's last chunk of solutions
+const unsigned int shm_task_done = 1u << 31;
+//a worker writes the solutions of a task once this many bytes have been collected, or the task is done
+const size_t shm_chunk_bytes = 1 << 16;
+
+//the control block at the start of the shared window
+struct ShmControl
+{
+    std::atomic<uint64_t> dequeue_position; //next task to be claimed, shared by the workers
+    char dequeue_padding[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint32_t> done_publishing; //set by the master once all tasks are in the queue
+    char done_padding[64 - sizeof(std::atomic<uint32_t>)];
+};
+
+/**
+ * @brief A slot of the shared task queue.
+ *
+ * The queue is a bounded multi-consumer queue: slot `i % capacity` holds
+ * task `i` once its sequence number is `i + 1`, and is free for task
+ * `i + capacity` once a worker has set it to `i + capacity`.
+ */
+struct TaskSlot
+{
+    std::atomic<uint64_t> sequence;
+    unsigned int* prefix() { return reinterpret_cast<unsigned int*>(this + 1); }
+};
+
+//the layout of the shared window, computed identically on every rank
+struct ShmLayout
+{
+    ShmControl* control;
+    char* slots;
+    size_t slot_size;
+    char* rings;
+    size_t ring_size;
+    int num_workers;
+
+    TaskSlot& slot(uint64_t position) { return *reinterpret_cast<TaskSlot*>(slots + (position % shm_task_capacity) * slot_size); }
+    ShmRing& ring(int worker) { return *reinterpret_cast<ShmRing*>(rings + (worker - 1) * ring_size); }
+    //set by a worker after its last result has been written to its ring
+    std::atomic<uint32_t>& finished(int worker) { return *reinterpret_cast<std::atomic<uint32_t>*>(rings + num_workers * ring_size + (worker - 1) * 64); }
+};
+
+/**
+ * @brief Computes the layout of the window for the given problem and number of ranks.
+ */
+ShmLayout compute_layout(char* base, unsigned int k, int num_ranks, size_t& total_size)
+{
+    ShmLayout layout;
+    layout.num_workers = num_ranks - 1;
+    layout.slot_size = ((sizeof(TaskSlot) + k * sizeof(unsigned int) + 63) / 64) * 64;
+    layout.ring_size = ShmRing::footprint(shm_result_capacity);
+    layout.control = reinterpret_cast<ShmControl*>(base);
+    layout.slots = base + sizeof(ShmControl);
+    layout.rings = layout.slots + shm_task_capacity * layout.slot_size;
+    total_size = sizeof(ShmControl) + shm_task_capacity * layout.slot_size + layout.num_workers * (layout.ring_size + 64);
+    return layout;
+}
+
+/**
+ * @brief Allocates the shared window on rank 0 of MPI_COMM_WORLD and maps it on all ranks.
+ */
+ShmLayout allocate_window(unsigned int k, MPI_Comm& node_comm, MPI_Win& window)
+{
+    int rank, num_ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+    //keyed by the world rank, so ranks keep their numbers in the node communicator
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+
+    size_t total_size;
+    compute_layout(NULL, k, num_ranks, total_size);
+    char* base;
+    MPI_Win_allocate_shared(rank == 0 ? total_size : 0, 1, MPI_INFO_NULL, node_comm, &base, &window);
+    if(rank != 0)
+    {
+        MPI_Aint size;
+        int disp_unit;
+        MPI_Win_shared_query(window, 0, &size, &disp_unit, &base);
+    }
+    ShmLayout layout = compute_layout(base, k, num_ranks, total_size);
+
+    //the master constructs the shared objects before anyone uses them
+    if(rank == 0)
+    {
+        new (&layout.control->dequeue_position) std::atomic<uint64_t>(0);
+        new (&layout.control->done_publishing) std::atomic<uint32_t>(0);
+        for(uint64_t i = 0; i < shm_task_capacity; ++i) new (&layout.slot(i).sequence) std::atomic<uint64_t>(i);
+        for(int worker = 1; worker < num_ranks; ++worker)
+        {
+            ShmRing::create(&layout.ring(worker), shm_result_capacity);
+            new (&layout.finished(worker)) std::atomic<uint32_t>(0);
+        }
+    }
+    MPI_Barrier(node_comm);
+    return layout;
+}
+
+/**
+ * @brief Frees the shared window once every rank is done with it.
+ */
+void free_window(MPI_Comm& node_comm, MPI_Win& window)
+{
+    MPI_Win_free(&window);
+    MPI_Comm_free(&node_comm);
+}
+
+bool ranks_share_node(MPI_Comm comm)
+{
+    int rank, size, node_size;
+    MPI_Comm node_comm;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_size(node_comm, &node_size);
+    MPI_Comm_free(&node_comm);
+    return node_size == size;
+}
+
+//how far the master has read the chunk a worker's ring is in the middle of
+struct ShmChunk
+{
+    unsigned int task;       //the header's task field
+    uint64_t solutions_left; //solutions of the chunk not read yet, 0 between chunks
+};
+
+//the master's view of the shared window, used from within its nqueens_by_level callback
+struct ShmMaster
+{
+    static ShmLayout& layout()
+    {
+        static ShmLayout master_layout;
+        return master_layout;
+    }
+    static uint64_t& enqueue_position()
+    {
+        static uint64_t position;
+        return position;
+    }
+    static unsigned int& n()
+    {
+        static unsigned int problem_size;
+        return problem_size;
+    }
+    static ReorderBuffer*& reorder()
+    {
+        static ReorderBuffer* buffer;
+        return buffer;
+    }
+    //per worker: the chunk its ring is in the middle of
+    static std::vector<ShmChunk>& chunks()
+    {
+        static std::vector<ShmChunk> worker_chunks;
+        return worker_chunks;
+    }
+};
+
+/**
+ * @brief Passes everything currently in a worker's ring to the master's reorder buffer.
+ *
+ * The worker writes the solutions of a task in chunks: a header of the task
+ * id, or'ed with shm_task_done for the task's last chunk, and the number of
+ * solutions, followed by the solutions.  The solutions are appended straight
+ * from the ring, as many as are contiguous in it, and only then released to
+ * the worker; a solution that wraps around the end of the ring is copied.
+ *
+ * @returns true if anything was read.
+ */
+bool drain_ring(ShmRing& ring, ShmChunk& chunk)
+{
+    unsigned int n = ShmMaster::n();
+    size_t solution_bytes = n * sizeof(unsigned int);
+    ReorderBuffer& reorder = *ShmMaster::reorder();
+    static std::vector<unsigned int> wrapped;
+    bool drained = false;
+    while(true)
+    {
+        if(chunk.solutions_left == 0)
+        {
+            unsigned int header[2];
+            if(ring.readable() < sizeof(header)) return drained;
+            ring.read(header, sizeof(header));
+            chunk.task = header[0];
+            chunk.solutions_left = header[1];
+        }
+        else
+        {
+            size_t size;
+            const unsigned int* solutions = reinterpret_cast<const unsigned int*>(ring.readable_span(size));
+            size_t num_solutions = std::min<uint64_t>(chunk.solutions_left, size / solution_bytes);
+            if(num_solutions > 0)
+            {
+                reorder.append(chunk.task & ~shm_task_done, solutions, solutions + num_solutions * n);
+                ring.consume(num_solutions * solution_bytes);
+            }
+            else
+            {
+                //not written completely yet, or split by the end of the ring
+                if(ring.readable() < solution_bytes) return drained;
+                wrapped.resize(n);
+                ring.read(wrapped.data(), solution_bytes);
+                reorder.append(chunk.task & ~shm_task_done, wrapped.data(), wrapped.data() + n);
+                num_solutions = 1;
+            }
+            chunk.solutions_left -= num_solutions;
+        }
+        drained = true;
+        if(chunk.solutions_left == 0 && (chunk.task & shm_task_done))
+        {
+            reorder.complete(chunk.task & ~shm_task_done);
+            chunk.task = 0;
+        }
+    }
+}
+
+/**
+ * @brief Passes everything currently in the workers' rings to the master's reorder buffer.
+ *
+ * @returns true if anything was read.
+ */
+bool drain_results()
+{
+    ShmLayout& layout = ShmMaster::layout();
+    bool drained = false;
+    for(int worker = 1; worker <= layout.num_workers; ++worker)
+    {
+        if(drain_ring(layout.ring(worker), ShmMaster::chunks()[worker])) drained = true;
+    }
+    return drained;
+}
+
+/**
+ * @brief The master's call back function: publishes the partial solution in the shared task queue.
+ *
+ * While the queue is full, or the task is too far ahead of the oldest
+ * unfinished task for the reorder buffer, the master empties the result
+ * rings instead, so workers blocked on a full ring can continue and free
+ * queue slots.
+ */
+void shm_master_solution_func(std::vector<unsigned int>& solution)
+{
+    ShmLayout& layout = ShmMaster::layout();
+    uint64_t position = ShmMaster::enqueue_position();
+    TaskSlot& slot = layout.slot(position);
+    while(slot.sequence.load(std::memory_order_acquire) != position || !ShmMaster::reorder()->has_room(position))
+    {
+        if(!drain_results()) std::this_thread::yield();
+    }
+    std::copy(solution.begin(), solution.end(), slot.prefix());
+    slot.sequence.store(position + 1, std::memory_order_release);
+    ShmMaster::enqueue_position() = position + 1;
+}
+
+void shm_master_main(unsigned int n, unsigned int k, SolutionSink& output)
+{
+    MPI_Comm node_comm;
+    MPI_Win window;
+    ShmMaster::layout() = allocate_window(k, node_comm, window);
+    ShmMaster::enqueue_position() = 0;
+    ShmMaster::n() = n;
+    //the task queue bounds the tasks in flight, so a window of its capacity never holds the master back
+    ReorderBuffer reorder(output, shm_task_capacity);
+    ShmMaster::reorder() = &reorder;
+    ShmChunk between_chunks = {0, 0};
+    ShmMaster::chunks().assign(ShmMaster::layout().num_workers + 1, between_chunks);
+
+    // generate all partial solutions (up to level k), on prefix_threads() threads, and publish them
+    generate_prefixes(NULL, n, k, &shm_master_solution_func);
+    ShmLayout& layout = ShmMaster::layout();
+    layout.control->done_publishing.store(1, std::memory_order_release);
+
+    //collect results until every worker has finished and its ring is empty
+    for(int worker = 1; worker <= layout.num_workers; ++worker)
+    {
+        while(layout.finished(worker).load(std::memory_order_acquire) == 0 || layout.ring(worker).readable() > 0)
+        {
+            if(!drain_results()) std::this_thread::yield();
+        }
+    }
+
+    ShmMaster::reorder() = NULL;
+    free_window(node_comm, window);
+}
+
+//the ring buffer of this worker and the chunk being collected, used from within its nqueens_by_level callback
+struct ShmWorkerRing
+{
+    static ShmRing*& ring()
+    {
+        static ShmRing* worker_ring;
+        return worker_ring;
+    }
+    //the header of the current task's chunk, its id and number of solutions, followed by the solutions
+    static std::vector<unsigned int>& chunk()
+    {
+        static std::vector<unsigned int> current;
+        return current;
+    }
+    //writes the chunk to the ring and starts the next one of the same task
+    static void write_chunk()
+    {
+        ring()->write(chunk().data(), chunk().size() * sizeof(unsigned int));
+        chunk().resize(2);
+        chunk()[1] = 0;
+    }
+};
+
+/**
+ * @brief The workers' call back function: collects the solution into the task's chunk, which is
+ *        streamed into the worker's ring once it is full.
+ */
+void shm_worker_solution_func(std::vector<unsigned int>& solution)
+{
+    std::vector<unsigned int>& chunk = ShmWorkerRing::chunk();
+    chunk.insert(chunk.end(), solution.begin(), solution.end());
+    ++chunk[1];
+    if(chunk.size() * sizeof(unsigned int) >= shm_chunk_bytes) ShmWorkerRing::write_chunk();
+}
+
+/**
+ * @brief Claims the next task from the shared queue.  Returns false if the queue is empty.
+ */
+bool claim_task(ShmLayout& layout, unsigned int k, std::vector<unsigned int>& pos, uint64_t& task_id)
+{
+    uint64_t position = layout.control->dequeue_position.load(std::memory_order_relaxed);
+    while(true)
+    {
+        TaskSlot& slot = layout.slot(position);
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if(sequence == position + 1)
+        {
+            //the task is published: try to claim it before another worker does
+            if(layout.control->dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                std::copy(slot.prefix(), slot.prefix() + k, pos.begin());
+                slot.sequence.store(position + shm_task_capacity, std::memory_order_release);
+                task_id = position;
+                return true;
+            }
+        }
+        else if(sequence < position + 1) return false; //not published yet
+        else position = layout.control->dequeue_position.load(std::memory_order_relaxed);
+    }
+}
+
+void shm_worker_main(unsigned int n, unsigned int k)
+{
+    MPI_Comm node_comm;
+    MPI_Win window;
+    ShmLayout layout = allocate_window(k, node_comm, window);
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    ShmWorkerRing::ring() = &layout.ring(rank);
+
+    std::vector<unsigned int> pos(n);
+    std::vector<unsigned int>& chunk = ShmWorkerRing::chunk();
+    chunk.reserve(shm_chunk_bytes / sizeof(unsigned int) + n);
+    chunk.assign(2, 0);
+    uint64_t task_id;
+    while(true)
+    {
+        //read before claiming: if the master was done before an unsuccessful claim, no task can be missed
+        bool done = layout.control->done_publishing.load(std::memory_order_acquire) != 0;
+        if(claim_task(layout, k, pos, task_id))
+        {
+            chunk[0] = static_cast<unsigned int>(task_id);
+            nqueens_by_level(pos, k, n, &shm_worker_solution_func);
+            //the last chunk ends the task, even without solutions
+            chunk[0] |= shm_task_done;
+            ShmWorkerRing::write_chunk();
+            continue;
+        }
+        if(done) break;
+        std::this_thread::yield();
+    }
+    layout.finished(rank).store(1, std::memory_order_release);
+
+    free_window(node_comm, window);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file    mpi_shm_nqueens.h
+ * @brief   Declares the shared memory variant of the parallel solver, used
+ *          when all MPI ranks run on the same node.
+ *
+ * Instead of sending every partial solution and every result as an MPI
+ * message, the ranks share one MPI-3 shared memory window.  The master
+ * publishes the partial solutions into a shared task queue from which idle
+ * workers claim them directly, and every worker streams its solutions into
+ * its own ring buffer in the window, from which the master copies them
+ * straight into the final result.
+ */
+
+#ifndef MPI_SHM_NQUEENS_H
+#define MPI_SHM_NQUEENS_H
+
+#include <vector>
+#include <mpi.h>
+
+#include "solution_sink.h"
+
+/**
+ * @brief Returns true if all ranks of `comm` share one node.  Collective.
+ */
+bool ranks_share_node(MPI_Comm comm);
+
+/**
+ * @brief The master's part of the shared memory solver.  Collective over
+ *        MPI_COMM_WORLD together with shm_worker_main() on all other ranks.
+ *
+ * @param n     The size of the nqueens problem.
+ * @param k     The number of levels the master solves.
+ * @param output Receives all solutions, in the order of the sequential solver.
+ */
+void shm_master_main(unsigned int n, unsigned int k, SolutionSink& output);
+
+/**
+ * @brief A worker's part of the shared memory solver.
+ */
+void shm_worker_main(unsigned int n, unsigned int k);
+
+#endif // MPI_SHM_NQUEENS_H
@@ -0,0 +1,36 @@
+/**
+ * @file    mpi_transport.cpp
+ * @brief   Implements the MPI transport.
+ */
+
+#include "mpi_transport.h"
+
+#include "huge_pages.h"
+
+MpiTransport::MpiTransport(MPI_Comm comm) : comm(comm)
+{
+    MPI_Comm_rank(comm, &comm_rank);
+    MPI_Comm_size(comm, &comm_size);
+}
+
+void MpiTransport::send(int dest, int tag, const unsigned int* data, size_t count)
+{
+    MPI_Send(const_cast<unsigned int*>(data), count, MPI_UNSIGNED, dest, tag, comm);
+}
+
+void MpiTransport::recv(int source, Message& message)
+{
+    //get the size of the next message and allocate space for it
+    MPI_Status status;
+    int count = 0;
+    MPI_Probe(source == any_source ? MPI_ANY_SOURCE : source, MPI_ANY_TAG, comm, &status);
+    MPI_Get_count(&status, MPI_UNSIGNED, &count);
+    message.source = status.MPI_SOURCE;
+    message.tag = status.MPI_TAG;
+    //large results land in huge pages; the master reuses the buffer for every message
+    reserve_huge(message.data, count);
+    message.data.resize(count);
+
+    //receive exactly the probed message
+    MPI_Recv(message.data.data(), count, MPI_UNSIGNED, status.MPI_SOURCE, status.MPI_TAG, comm, MPI_STATUS_IGNORE);
+}
@@ -0,0 +1,31 @@
+/**
+ * @file    mpi_transport.h
+ * @brief   Declares the MPI implementation of the master-worker transport.
+ */
+
+#ifndef MPI_TRANSPORT_H
+#define MPI_TRANSPORT_H
+
+#include <mpi.h>
+
+#include "transport.h"
+
+/**
+ * @brief Sends messages as MPI point-to-point messages within a communicator.
+ */
+class MpiTransport : public Transport
+{
+public:
+    explicit MpiTransport(MPI_Comm comm);
+
+    int rank() const { return comm_rank; }
+    int size() const { return comm_size; }
+    void send(int dest, int tag, const unsigned int* data, size_t count);
+    void recv(int source, Message& message);
+
+private:
+    MPI_Comm comm;
+    int comm_rank, comm_size;
+};
+
+#endif // MPI_TRANSPORT_H
@@ -0,0 +1,150 @@
+/**
+ * @file    nqueens_cache.cpp
+ * @brief   Implements the binary solution files and the on-disk result cache.
+ */
+
+#include "nqueens_cache.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+
+MappedSolutionFile::MappedSolutionFile() : mapping(NULL), mapping_size(0) {}
+
+MappedSolutionFile::~MappedSolutionFile()
+{
+    close();
+}
+
+bool MappedSolutionFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) return false;
+
+    struct stat file_stat;
+    if(fstat(fd, &file_stat) < 0 || static_cast<size_t>(file_stat.st_size) < sizeof(SolutionFileHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); //the mapping stays valid after closing the descriptor
+    if(data == MAP_FAILED) return false;
+
+    //reject files from other engine versions and truncated files
+    const SolutionFileHeader* file_header = static_cast<const SolutionFileHeader*>(data);
+    if(file_header->magic != solution_file_magic || file_header->version != nqueens_engine_version
+       || sizeof(SolutionFileHeader) + file_header->num_values * sizeof(unsigned int) != static_cast<size_t>(file_stat.st_size))
+    {
+        munmap(data, file_stat.st_size);
+        return false;
+    }
+    mapping = data;
+    mapping_size = file_stat.st_size;
+    return true;
+}
+
+void MappedSolutionFile::close()
+{
+    if(mapping != NULL) munmap(mapping, mapping_size);
+    mapping = NULL;
+    mapping_size = 0;
+}
+
+const unsigned int* MappedSolutionFile::solutions() const
+{
+    return reinterpret_cast<const unsigned int*>(static_cast<const char*>(mapping) + sizeof(SolutionFileHeader));
+}
+
+SolutionFileWriter::SolutionFileWriter() : file(NULL), ok(false) {}
+
+SolutionFileWriter::~SolutionFileWriter()
+{
+    abort();
+}
+
+bool SolutionFileWriter::open(const std::string& file_path, unsigned int n, Solve_Mode mode)
+{
+    abort();
+    file_header.magic = solution_file_magic;
+    file_header.version = nqueens_engine_version;
+    file_header.n = n;
+    file_header.mode = mode;
+    file_header.count = 0;
+    file_header.num_values = 0;
+
+    path = file_path;
+    temp_path = path + ".tmp." + std::to_string(getpid());
+    file = fopen(temp_path.c_str(), "wb");
+    if(file == NULL) return false;
+    //the header is rewritten with the final sizes by commit()
+    ok = fwrite(&file_header, sizeof(file_header), 1, file) == 1;
+    return ok;
+}
+
+bool SolutionFileWriter::append(const unsigned int* solutions, size_t size)
+{
+    if(file == NULL) return false;
+    ok = ok && (size == 0 || fwrite(solutions, sizeof(unsigned int), size, file) == size);
+    file_header.num_values += size;
+    return ok;
+}
+
+bool SolutionFileWriter::commit(unsigned long long count)
+{
+    if(file == NULL) return false;
+    file_header.count = count;
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&file_header, sizeof(file_header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    file = NULL;
+    if(!ok || rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void SolutionFileWriter::abort()
+{
+    if(file == NULL) return;
+    fclose(file);
+    file = NULL;
+    unlink(temp_path.c_str());
+}
+
+bool write_solution_file(const std::string& path, unsigned int n, Solve_Mode mode, unsigned long long count,
+                         const unsigned int* solutions, size_t size)
+{
+    SolutionFileWriter writer;
+    return writer.open(path, n, mode) && writer.append(solutions, size) && writer.commit(count);
+}
+
+std::string cache_path(const std::string& cache_dir, unsigned int n, Solve_Mode mode)
+{
+    return cache_dir + "/nqueens-v" + std::to_string(nqueens_engine_version) + "-" + mode_name(mode) + "-" + std::to_string(n) + ".bin";
+}
+
+bool cache_lookup(const std::string& cache_dir, unsigned int n, Solve_Mode mode, MappedSolutionFile& file)
+{
+    if(file.open(cache_path(cache_dir, n, mode)) && file.header().n == n) return true;
+    if(mode == count_mode && file.open(cache_path(cache_dir, n, all_mode)) && file.header().n == n) return true;
+    file.close();
+    return false;
+}
+
+bool cache_store(const std::string& cache_dir, unsigned int n, Solve_Mode mode, unsigned long long count,
+                 const unsigned int* solutions, size_t size)
+{
+    create_cache_dir(cache_dir);
+    if(mode == count_mode) size = 0;
+    return write_solution_file(cache_path(cache_dir, n, mode), n, mode, count, solutions, size);
+}
+
+void create_cache_dir(const std::string& cache_dir)
+{
+    mkdir(cache_dir.c_str(), 0755); //fails harmlessly if it already exists
+}
@@ -0,0 +1,169 @@
+/**
+ * @file    nqueens_cache.h
+ * @brief   Declares the binary solution file format and the persistent
+ *          on-disk result cache built on top of it.
+ *
+ * A solution file is a fixed header followed by the concatenated solutions
+ * as native `unsigned int`s, so it can be memory mapped and used in place.
+ * The cache keeps one such file per (n, mode, engine version) in a directory.
+ */
+
+#ifndef NQUEENS_CACHE_H
+#define NQUEENS_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+
+#include "nqueens_mode.h"
+
+//bump whenever a change to the solvers changes their results (or their order), so stale cache files are ignored
+const uint32_t nqueens_engine_version = 2;
+
+//"NQSF" in a little endian file
+const uint32_t solution_file_magic = 0x4653514e;
+
+//the header at the start of every solution file
+struct SolutionFileHeader
+{
+    uint32_t magic;
+    uint32_t version;       //engine version that produced the file
+    uint32_t n;
+    uint32_t mode;          //Solve_Mode of the stored result
+    uint64_t count;         //number of solutions (the full count, also in count mode)
+    uint64_t num_values;    //number of unsigned ints following the header
+};
+
+/**
+ * @brief A read-only memory mapping of a solution file.
+ *
+ * The solutions are used in place; nothing is read until it is accessed.
+ */
+class MappedSolutionFile
+{
+public:
+    MappedSolutionFile();
+    ~MappedSolutionFile();
+
+    /**
+     * @brief Maps the given file.  Returns false if it does not exist or is not a valid solution file.
+     */
+    bool open(const std::string& path);
+    void close();
+
+    const SolutionFileHeader& header() const { return *static_cast<const SolutionFileHeader*>(mapping); }
+    const unsigned int* solutions() const;
+    size_t size() const { return header().num_values; }
+
+private:
+    MappedSolutionFile(const MappedSolutionFile&);
+    MappedSolutionFile& operator=(const MappedSolutionFile&);
+
+    void* mapping;
+    size_t mapping_size;
+};
+
+/**
+ * @brief Writes a solution file incrementally, for results that are not held in memory as a whole.
+ *
+ * Like write_solution_file(), the file is written under a temporary name and
+ * only appears under its final name once commit() succeeds.
+ */
+class SolutionFileWriter
+{
+public:
+    SolutionFileWriter();
+    ~SolutionFileWriter();
+
+    /**
+     * @brief Starts writing the file.  Returns false if the temporary file cannot be created.
+     */
+    bool open(const std::string& path, unsigned int n, Solve_Mode mode);
+
+    /**
+     * @brief Appends `size` unsigned ints of solutions.
+     */
+    bool append(const unsigned int* solutions, size_t size);
+
+    /**
+     * @brief Completes the header with the given count and renames the file to its final name.
+     */
+    bool commit(unsigned long long count);
+
+    /**
+     * @brief Discards a file that has not been committed.
+     */
+    void abort();
+
+private:
+    SolutionFileWriter(const SolutionFileWriter&);
+    SolutionFileWriter& operator=(const SolutionFileWriter&);
+
+    FILE* file;
+    std::string path, temp_path;
+    SolutionFileHeader file_header;
+    bool ok;
+};
+
+/**
+ * @brief Writes a solution file.  The file is written under a temporary name
+ *        and renamed, so readers never see a partial file.
+ *
+ * @returns false if the file could not be written.
+ */
+bool write_solution_file(const std::string& path, unsigned int n, Solve_Mode mode, unsigned long long count,
+                         const unsigned int* solutions, size_t size);
+
+/**
+ * @brief Returns the path of the cache file for (n, mode) in the cache directory.
+ */
+std::string cache_path(const std::string& cache_dir, unsigned int n, Solve_Mode mode);
+
+/**
+ * @brief Looks up a cached result for (n, mode) in the cache directory.
+ *
+ * A count query is also answered by a cached "all" result.
+ *
+ * @returns true and maps the cached file into `file` on a hit.
+ */
+bool cache_lookup(const std::string& cache_dir, unsigned int n, Solve_Mode mode, MappedSolutionFile& file);
+
+/**
+ * @brief Stores a result in the cache directory.  In count mode only the count is stored.
+ */
+bool cache_store(const std::string& cache_dir, unsigned int n, Solve_Mode mode, unsigned long long count,
+                 const unsigned int* solutions, size_t size);
+
+/**
+ * @brief Creates the cache directory if it does not exist yet.
+ */
+void create_cache_dir(const std::string& cache_dir);
+
+/**
+ * @brief Writes all solutions of a solution store as solution file, one solution at a time.
+ *
+ * `Store` is any store with n(), size() and a Cursor (see compressed_store.h).
+ */
+template <class Store>
+bool write_solution_file(const std::string& path, const Store& store)
+{
+    SolutionFileWriter writer;
+    if(!writer.open(path, store.n(), all_mode)) return false;
+    typename Store::Cursor cursor(store);
+    bool ok = true;
+    while(ok && cursor.next()) ok = writer.append(cursor.solution(), store.n());
+    return ok && writer.commit(store.size());
+}
+
+/**
+ * @brief Stores all solutions of a solution store as the "all" result for its n in the cache directory.
+ */
+template <class Store>
+bool cache_store(const std::string& cache_dir, const Store& store)
+{
+    create_cache_dir(cache_dir);
+    return write_solution_file(cache_path(cache_dir, store.n(), all_mode), store);
+}
+
+#endif // NQUEENS_CACHE_H
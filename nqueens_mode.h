@@ -0,0 +1,45 @@
+/**
+ * @file    nqueens_mode.h
+ * @brief   Declares the query modes understood by the solvers (count only,
+ *          first solution, all solutions).
+ */
+
+#ifndef NQUEENS_MODE_H
+#define NQUEENS_MODE_H
+
+#include <string>
+
+//defines what a query asks for.  The numeric values are used in file formats and messages, so never reorder them
+enum Solve_Mode
+{
+    count_mode = 0,
+    first_mode = 1,
+    all_mode = 2
+};
+
+/**
+ * @brief Returns the name of the given mode as used on the command line and in the server protocol.
+ */
+inline const char* mode_name(Solve_Mode mode)
+{
+    switch(mode)
+    {
+        case count_mode: return "count";
+        case first_mode: return "first";
+        default: return "all";
+    }
+}
+
+/**
+ * @brief Parses a mode name.  Returns false if the name is not a known mode.
+ */
+inline bool parse_mode(const std::string& name, Solve_Mode& mode)
+{
+    if(name == "count") mode = count_mode;
+    else if(name == "first") mode = first_mode;
+    else if(name == "all") mode = all_mode;
+    else return false;
+    return true;
+}
+
+#endif // NQUEENS_MODE_H
@@ -0,0 +1,416 @@
+/**
+ * @file    nqueens_server.cpp
+ * @brief   Implements the local query server.
+ */
+
+#include "nqueens_server.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <pthread.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <map>
+#include <list>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <iostream>
+
+#include "nqueens_threads.h"
+#include "nqueens_cache.h"
+#include "solution_index.h"
+
+//a cached query result.  `ready` is false while the result is still being computed
+struct CacheEntry
+{
+    bool ready;
+    unsigned long long last_used; //the cache's use counter at the last lookup, for LRU eviction
+    SolveResult result;
+};
+
+//a solution index.  `ready` is false while the index is still being built
+struct IndexEntry
+{
+    bool ready;
+    SolutionIndex index;
+};
+
+//the in-memory result cache shared by all connections, keyed by (n, mode)
+struct ResultCache
+{
+    std::string cache_dir; //persistent cache behind the in-memory one, may be empty
+    std::map<std::pair<unsigned int, int>, std::shared_ptr<CacheEntry> > entries;
+    std::map<unsigned int, std::shared_ptr<IndexEntry> > indexes; //solution index by n
+    size_t max_bytes;             //budget for the solutions of the ready entries
+    size_t cached_bytes;          //the solutions held by the ready entries
+    unsigned long long use_count; //incremented by every lookup
+    std::mutex cache_mutex;
+    std::condition_variable entry_ready;
+};
+
+//a client connection and the thread serving it.  The fd is closed only once the thread is joined, so
+//shutting it down to stop the server never hits a descriptor that was reused in the meantime
+struct Connection
+{
+    int fd;
+    std::thread thread;
+    std::atomic<bool> finished;
+};
+
+//set by the signal handler to stop accepting connections
+volatile sig_atomic_t server_stopping = 0;
+
+void handle_stop_signal(int)
+{
+    server_stopping = 1;
+}
+
+void block_stop_signals()
+{
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+}
+
+/**
+ * @brief Returns the bytes of solutions held by a cache entry.
+ */
+size_t entry_bytes(const CacheEntry& entry)
+{
+    return entry.result.solutions.size() * sizeof(unsigned int);
+}
+
+/**
+ * @brief Evicts the least recently used ready entries until the cache fits its byte budget.
+ *        Clients still holding an evicted entry keep it alive until they are done with it.
+ *        Requires cache_mutex to be held.
+ */
+void evict_entries(ResultCache& cache)
+{
+    while(cache.cached_bytes > cache.max_bytes)
+    {
+        std::map<std::pair<unsigned int, int>, std::shared_ptr<CacheEntry> >::iterator oldest = cache.entries.end();
+        std::map<std::pair<unsigned int, int>, std::shared_ptr<CacheEntry> >::iterator it;
+        for(it = cache.entries.begin(); it != cache.entries.end(); ++it)
+        {
+            if(it->second->ready && entry_bytes(*it->second) > 0 &&
+               (oldest == cache.entries.end() || it->second->last_used < oldest->second->last_used))
+                oldest = it;
+        }
+        if(oldest == cache.entries.end()) return;
+        cache.cached_bytes -= entry_bytes(*oldest->second);
+        cache.entries.erase(oldest);
+    }
+}
+
+/**
+ * @brief Returns the result of the query, computing it at most once for all clients.
+ */
+std::shared_ptr<CacheEntry> lookup_or_solve(ResultCache& cache, SolverPool& pool, unsigned int k, unsigned int n, Solve_Mode mode)
+{
+    std::pair<unsigned int, int> key(n, mode);
+    std::unique_lock<std::mutex> lock(cache.cache_mutex);
+
+    std::map<std::pair<unsigned int, int>, std::shared_ptr<CacheEntry> >::iterator it = cache.entries.find(key);
+    if(it != cache.entries.end())
+    {
+        //either cached or being computed for another client: wait for that computation instead of starting a new one
+        std::shared_ptr<CacheEntry> entry = it->second;
+        entry->last_used = ++cache.use_count;
+        while(!entry->ready) cache.entry_ready.wait(lock);
+        return entry;
+    }
+
+    //a finished "all" query also answers count and first queries
+    it = cache.entries.find(std::make_pair(n, static_cast<int>(all_mode)));
+    if(mode != all_mode && it != cache.entries.end() && it->second->ready)
+    {
+        it->second->last_used = ++cache.use_count;
+        std::shared_ptr<CacheEntry> entry = std::make_shared<CacheEntry>();
+        entry->ready = true;
+        entry->last_used = ++cache.use_count;
+        entry->result.n = n;
+        entry->result.count = it->second->result.count;
+        if(mode == first_mode && entry->result.count > 0)
+        {
+            entry->result.count = 1;
+            entry->result.solutions.assign(it->second->result.solutions.begin(), it->second->result.solutions.begin() + n);
+        }
+        cache.entries[key] = entry;
+        cache.cached_bytes += entry_bytes(*entry);
+        evict_entries(cache);
+        return entry;
+    }
+
+    std::shared_ptr<CacheEntry> entry = std::make_shared<CacheEntry>();
+    entry->ready = false;
+    entry->last_used = ++cache.use_count;
+    cache.entries[key] = entry;
+    lock.unlock();
+
+    SolveResult result;
+    MappedSolutionFile cached;
+    if(!cache.cache_dir.empty() && cache_lookup(cache.cache_dir, n, mode, cached))
+    {
+        result.n = n;
+        result.count = cached.header().count;
+        if(mode != count_mode) result.solutions.assign(cached.solutions(), cached.solutions() + cached.size());
+    }
+    else
+    {
+        result = pool.solve(n, k, mode);
+        if(!cache.cache_dir.empty()) cache_store(cache.cache_dir, n, mode, result.count, result.solutions.data(), result.solutions.size());
+    }
+
+    lock.lock();
+    entry->result.n = result.n;
+    entry->result.count = result.count;
+    entry->result.solutions.swap(result.solutions);
+    entry->ready = true;
+    cache.cached_bytes += entry_bytes(*entry);
+    evict_entries(cache);
+    cache.entry_ready.notify_all();
+    return entry;
+}
+
+/**
+ * @brief Returns the solution index for n, building it at most once for all clients.
+ */
+std::shared_ptr<IndexEntry> lookup_or_build_index(ResultCache& cache, SolverPool& pool, unsigned int n)
+{
+    std::unique_lock<std::mutex> lock(cache.cache_mutex);
+    std::map<unsigned int, std::shared_ptr<IndexEntry> >::iterator it = cache.indexes.find(n);
+    if(it != cache.indexes.end())
+    {
+        std::shared_ptr<IndexEntry> entry = it->second;
+        while(!entry->ready) cache.entry_ready.wait(lock);
+        return entry;
+    }
+
+    std::shared_ptr<IndexEntry> entry = std::make_shared<IndexEntry>();
+    entry->ready = false;
+    cache.indexes[n] = entry;
+    lock.unlock();
+
+    SolutionIndex index;
+    load_or_build_index(index, n, pool, cache.cache_dir);
+
+    lock.lock();
+    std::swap(entry->index, index);
+    entry->ready = true;
+    cache.entry_ready.notify_all();
+    return entry;
+}
+
+/**
+ * @brief Writes the whole buffer to the socket.  Returns false if the client went away.
+ */
+bool write_all(int fd, const std::string& data)
+{
+    size_t written = 0;
+    while(written < data.size())
+    {
+        ssize_t ret = write(fd, data.data() + written, data.size() - written);
+        if(ret < 0 && errno == EINTR) continue;
+        if(ret <= 0) return false;
+        written += ret;
+    }
+    return true;
+}
+
+/**
+ * @brief Formats the reply for a finished query.
+ */
+std::string format_reply(const SolveResult& result, Solve_Mode mode)
+{
+    size_t lines = mode == count_mode ? 0 : result.solutions.size() / result.n;
+    std::string reply = "ok " + std::to_string(result.count) + " " + std::to_string(lines) + "\n";
+    reply.reserve(reply.size() + result.solutions.size() * 3);
+    for(size_t i = 0; i < lines; ++i)
+    {
+        for(unsigned int j = 0; j < result.n; ++j)
+        {
+            if(j != 0) reply += ' ';
+            reply += std::to_string(result.solutions[i * result.n + j]);
+        }
+        reply += '\n';
+    }
+    return reply;
+}
+
+/**
+ * @brief Parses and answers a single request line.
+ */
+std::string answer_request(const std::string& line, ResultCache& cache, SolverPool& pool, unsigned int k)
+{
+    std::istringstream request(line);
+    std::string mode_string;
+    long n = 0;
+    Solve_Mode mode;
+    if(line.compare(0, 5, "page ") == 0)
+    {
+        long long first = -1, count = -1;
+        if(!(request >> mode_string >> n >> first >> count) || first < 0 || count < 0)
+            return "error expected 'page <n> <first> <count>'\n";
+        if(n <= 0 || n > static_cast<long>(server_max_n))
+            return "error n must be in [1, " + std::to_string(server_max_n) + "]\n";
+        if(count > static_cast<long long>(server_max_page))
+            return "error at most " + std::to_string(server_max_page) + " solutions per page\n";
+
+        std::shared_ptr<IndexEntry> entry = lookup_or_build_index(cache, pool, n);
+        SolveResult page;
+        page.n = n;
+        page.count = entry->index.count();
+        std::vector<unsigned int> solutions;
+        entry->index.page(first, count, solutions);
+        page.solutions.assign(solutions.begin(), solutions.end());
+        return format_reply(page, all_mode);
+    }
+    if(!(request >> mode_string >> n) || !parse_mode(mode_string, mode))
+        return "error expected '<count|first|all> <n>' or 'page <n> <first> <count>'\n";
+    if(n <= 0 || n > static_cast<long>(server_max_n))
+        return "error n must be in [1, " + std::to_string(server_max_n) + "]\n";
+
+    std::shared_ptr<CacheEntry> entry = lookup_or_solve(cache, pool, k, n, mode);
+    return format_reply(entry->result, mode);
+}
+
+/**
+ * @brief Serves all requests of one client connection until the client or the server closes it.
+ */
+void serve_connection(Connection* connection, ResultCache& cache, SolverPool& pool, unsigned int k)
+{
+    int fd = connection->fd;
+    std::string buffer;
+    char chunk[4096];
+    while(true)
+    {
+        ssize_t ret = read(fd, chunk, sizeof(chunk));
+        if(ret < 0 && errno == EINTR) continue;
+        if(ret <= 0) break;
+        buffer.append(chunk, ret);
+
+        //answer every complete line received so far
+        size_t newline;
+        bool client_alive = true;
+        while(client_alive && (newline = buffer.find('\n')) != std::string::npos)
+        {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if(line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            client_alive = write_all(fd, answer_request(line, cache, pool, k));
+        }
+        if(!client_alive) break;
+    }
+    connection->finished.store(true);
+}
+
+/**
+ * @brief Joins and closes the finished connections, or all of them.
+ */
+void reap_connections(std::list<std::unique_ptr<Connection> >& connections, bool all)
+{
+    for(std::list<std::unique_ptr<Connection> >::iterator it = connections.begin(); it != connections.end();)
+    {
+        if(!all && !(*it)->finished.load())
+        {
+            ++it;
+            continue;
+        }
+        (*it)->thread.join();
+        close((*it)->fd);
+        it = connections.erase(it);
+    }
+}
+
+int run_server(const std::string& socket_path, SolverPool& pool, unsigned int k, const std::string& cache_dir,
+               size_t max_cache_bytes)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(socket_path.size() >= sizeof(address.sun_path))
+    {
+        std::cerr << "[ERROR]: socket path too long: " << socket_path << std::endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socket_path.c_str());
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listen_fd < 0)
+    {
+        perror("socket");
+        return 1;
+    }
+    unlink(socket_path.c_str()); //remove a stale socket of a previous run
+    if(bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listen_fd, 64) < 0)
+    {
+        perror(socket_path.c_str());
+        close(listen_fd);
+        return 1;
+    }
+
+    //stop on SIGINT/SIGTERM.  They are blocked in every thread (the connection threads inherit the mask) and
+    //only unblocked while this thread waits in ppoll(), which then returns with EINTR
+    struct sigaction stop_action;
+    memset(&stop_action, 0, sizeof(stop_action));
+    stop_action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &stop_action, NULL);
+    sigaction(SIGTERM, &stop_action, NULL);
+    signal(SIGPIPE, SIG_IGN); //a client closing early must not kill the server
+    block_stop_signals();
+    sigset_t wait_mask;
+    pthread_sigmask(SIG_BLOCK, NULL, &wait_mask);
+    sigdelset(&wait_mask, SIGINT);
+    sigdelset(&wait_mask, SIGTERM);
+
+    std::cerr << "Listening on " << socket_path << " with " << pool.num_threads() << " solver threads" << std::endl;
+
+    ResultCache cache;
+    cache.cache_dir = cache_dir;
+    cache.max_bytes = max_cache_bytes;
+    cache.cached_bytes = 0;
+    cache.use_count = 0;
+    std::list<std::unique_ptr<Connection> > connections;
+    while(!server_stopping)
+    {
+        pollfd listening;
+        listening.fd = listen_fd;
+        listening.events = POLLIN;
+        if(ppoll(&listening, 1, NULL, &wait_mask) < 0)
+        {
+            if(errno != EINTR) perror("ppoll");
+            continue;
+        }
+        int client_fd = accept(listen_fd, NULL, NULL);
+        if(client_fd < 0)
+        {
+            if(errno != EINTR) perror("accept");
+            continue;
+        }
+        reap_connections(connections, false);
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->fd = client_fd;
+        connection->finished.store(false);
+        connection->thread = std::thread(serve_connection, connection.get(), std::ref(cache), std::ref(pool), k);
+        connections.push_back(std::move(connection));
+    }
+
+    //the cache and the pool must outlive every connection: wake the threads waiting for requests and
+    //join them all, a request being answered completes first
+    for(std::list<std::unique_ptr<Connection> >::iterator it = connections.begin(); it != connections.end(); ++it)
+        shutdown((*it)->fd, SHUT_RDWR);
+    reap_connections(connections, true);
+
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ * @file    nqueens_server.h
+ * @brief   Declares the local query server, which answers n-queens queries
+ *          over a Unix domain socket from a warm solver pool and result cache.
+ *
+ * Protocol: the client sends one request per line, `<mode> <n>`, where mode
+ * is one of `count`, `first` or `all`.  The server answers with a line
+ * `ok <count> <lines>` followed by `<lines>` lines of space separated
+ * solutions (none in count mode), or with a single line `error <message>`.
+ * `page <n> <first> <m>` returns the solutions of lexicographic rank first,
+ * first + 1, ... first + m - 1 (counting from 0) from a solution index, see
+ * solution_index.h, in the same format.
+ * A connection may send any number of requests.
+ */
+
+#ifndef NQUEENS_SERVER_H
+#define NQUEENS_SERVER_H
+
+#include <string>
+#include <stddef.h>
+
+class SolverPool;
+
+//largest board size the server accepts
+const unsigned int server_max_n = 20;
+
+//largest number of solutions returned by one page request
+const unsigned int server_max_page = 100000;
+
+//default budget for the solutions cached in memory, in MB
+const unsigned int server_default_cache_mb = 1024;
+
+/**
+ * @brief Blocks SIGINT and SIGTERM in the calling thread and every thread it
+ *        creates afterwards.  Call it before creating the solver pool, so that
+ *        the signals only reach the thread in run_server().
+ */
+void block_stop_signals();
+
+/**
+ * @brief Runs the server until SIGINT or SIGTERM is received.
+ *
+ * Every connection is handled by its own thread.  Queries for the same
+ * (n, mode) are computed only once: concurrent identical queries wait for
+ * the single computation in flight, later ones are answered from the cache.
+ * Queries for different problems share the pool's task queue.
+ * If a cache directory is given, results missing from memory are looked up
+ * on disk before solving, and newly solved results are written there.
+ * The same holds for the solution index of every n, built on the first page
+ * request for it.
+ * The solutions kept in memory are limited to `max_cache_bytes`: beyond it the
+ * least recently used results are dropped and recomputed, or read back from
+ * the cache directory, when they are queried again.
+ *
+ * @param socket_path   Path of the Unix domain socket to listen on.
+ * @param pool          The solver pool used for all computations.
+ * @param k             The number of levels solved before handing partial
+ *                      solutions to the pool.
+ * @param cache_dir     The persistent result cache directory, or empty.
+ * @param max_cache_bytes The budget for the solutions cached in memory.
+ * @returns             0 on a clean shutdown, 1 if the socket could not be set up.
+ */
+int run_server(const std::string& socket_path, SolverPool& pool, unsigned int k, const std::string& cache_dir,
+               size_t max_cache_bytes);
+
+#endif // NQUEENS_SERVER_H
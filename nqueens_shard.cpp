@@ -0,0 +1,139 @@
+/**
+ * @file    nqueens_shard.cpp
+ * @brief   Implements the cost balanced assignment of partial solutions to shards.
+ */
+
+#include "nqueens_shard.h"
+
+#include <stdlib.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "nqueens.h"
+
+//the state of the cost probe, used from within its nqueens_by_level callbacks
+struct ShardProbe
+{
+    static std::vector<unsigned int>& prefixes()
+    {
+        static std::vector<unsigned int> prefs;
+        return prefs;
+    }
+    static uint64_t& count()
+    {
+        static uint64_t num_partials;
+        return num_partials;
+    }
+};
+
+//collects the partial solutions of the first k levels
+void shard_prefix_callback(std::vector<unsigned int>& solution)
+{
+    ShardProbe::prefixes().insert(ShardProbe::prefixes().end(), solution.begin(), solution.end());
+}
+
+//counts the partial solutions below a prefix
+void shard_probe_callback(std::vector<unsigned int>&)
+{
+    ++ShardProbe::count();
+}
+
+bool parse_shard(const std::string& text, Shard& shard)
+{
+    size_t slash = text.find('/');
+    if(slash == std::string::npos || slash == 0 || slash + 1 == text.size()) return false;
+    char* end;
+    long index = strtol(text.c_str(), &end, 10);
+    if(end != text.c_str() + slash) return false;
+    long count = strtol(text.c_str() + slash + 1, &end, 10);
+    if(*end != '\0' || index < 0 || count <= 0 || index >= count) return false;
+    shard.index = index;
+    shard.count = count;
+    return true;
+}
+
+//orders prefixes by decreasing cost, ties by their lexicographic position
+struct CostGreater
+{
+    const std::vector<uint64_t>& costs;
+    CostGreater(const std::vector<uint64_t>& c) : costs(c) {}
+    bool operator()(size_t a, size_t b) const
+    {
+        return costs[a] != costs[b] ? costs[a] > costs[b] : a < b;
+    }
+};
+
+std::vector<unsigned int> shard_prefixes(unsigned int n, unsigned int k, const Shard& shard, ShardManifest& manifest)
+{
+    //generate all partial solutions of the first k levels
+    std::vector<unsigned int> pos(n);
+    ShardProbe::prefixes().clear();
+    nqueens_by_level(pos, 0, k, &shard_prefix_callback);
+    std::vector<unsigned int> all_prefixes;
+    all_prefixes.swap(ShardProbe::prefixes());
+    size_t num_prefixes = all_prefixes.size() / k;
+
+    //estimate the cost of each by the number of its partial solutions a few levels deeper
+    unsigned int probe_level = std::min(k + shard_probe_levels, n);
+    std::vector<uint64_t> costs(num_prefixes);
+    for(size_t i = 0; i < num_prefixes; ++i)
+    {
+        std::copy(all_prefixes.begin() + i * k, all_prefixes.begin() + (i + 1) * k, pos.begin());
+        ShardProbe::count() = 0;
+        nqueens_by_level(pos, k, probe_level, &shard_probe_callback);
+        //every prefix costs something, even if it is a dead end
+        costs[i] = ShardProbe::count() + 1;
+    }
+
+    //longest processing time first: the next most expensive prefix goes to the least loaded shard
+    std::vector<size_t> order(num_prefixes);
+    for(size_t i = 0; i < num_prefixes; ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), CostGreater(costs));
+    std::vector<uint64_t> loads(shard.count, 0);
+    std::vector<size_t> selected;
+    for(size_t i = 0; i < num_prefixes; ++i)
+    {
+        unsigned int target = std::min_element(loads.begin(), loads.end()) - loads.begin();
+        loads[target] += costs[order[i]];
+        if(target == shard.index) selected.push_back(order[i]);
+    }
+    std::sort(selected.begin(), selected.end());
+
+    manifest.shard = shard;
+    manifest.n = n;
+    manifest.k = k;
+    manifest.num_prefixes = selected.size();
+    manifest.estimated_cost = loads[shard.index];
+
+    std::vector<unsigned int> prefixes(selected.size() * k);
+    for(size_t i = 0; i < selected.size(); ++i)
+        std::copy(all_prefixes.begin() + selected[i] * k, all_prefixes.begin() + (selected[i] + 1) * k, prefixes.begin() + i * k);
+    return prefixes;
+}
+
+std::string shard_manifest_path(const std::string& solution_path)
+{
+    return solution_path + ".shard";
+}
+
+bool write_shard_manifest(const std::string& path, const ShardManifest& manifest)
+{
+    std::ofstream out(path.c_str());
+    if(!out) return false;
+    out << "shard " << manifest.shard.index << ' ' << manifest.shard.count << " n " << manifest.n << " k " << manifest.k
+        << " prefixes " << manifest.num_prefixes << " cost " << manifest.estimated_cost << std::endl;
+    return static_cast<bool>(out);
+}
+
+bool read_shard_manifest(const std::string& path, ShardManifest& manifest)
+{
+    std::ifstream in(path.c_str());
+    std::string line, key_shard, key_n, key_k, key_prefixes, key_cost;
+    if(!in || !std::getline(in, line)) return false;
+    std::istringstream fields(line);
+    return (fields >> key_shard >> manifest.shard.index >> manifest.shard.count >> key_n >> manifest.n >> key_k >> manifest.k
+                   >> key_prefixes >> manifest.num_prefixes >> key_cost >> manifest.estimated_cost)
+           && key_shard == "shard" && key_n == "n" && key_k == "k" && key_prefixes == "prefixes" && key_cost == "cost"
+           && manifest.shard.index < manifest.shard.count;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file    nqueens_shard.h
+ * @brief   Declares the splitting of one enumeration into independent shards,
+ *          e.g. for the jobs of a PBS job array, and the manifest written
+ *          next to each shard's solution file so the shards can be merged.
+ *
+ * Every shard generates all partial solutions of the first `k` levels,
+ * estimates the cost of completing each by counting its partial solutions a
+ * few levels deeper, and assigns them to the shards longest-first.  The
+ * assignment only depends on (n, k, number of shards), so all jobs agree on it
+ * without communicating.
+ */
+
+#ifndef NQUEENS_SHARD_H
+#define NQUEENS_SHARD_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+//number of levels below k explored to estimate the cost of a partial solution
+const unsigned int shard_probe_levels = 2;
+
+//selects shard `index` of `count`
+struct Shard
+{
+    unsigned int index;
+    unsigned int count;
+};
+
+//what a shard run records about itself
+struct ShardManifest
+{
+    Shard shard;
+    unsigned int n, k;
+    uint64_t num_prefixes;
+    uint64_t estimated_cost; //sum of the cost estimates of the shard's prefixes
+};
+
+/**
+ * @brief Parses a shard given as `i/N` with 0 <= i < N.  Returns false on errors.
+ */
+bool parse_shard(const std::string& text, Shard& shard);
+
+/**
+ * @brief Returns the partial solutions of the first `k` levels that belong to the given shard.
+ *
+ * @param n         The size of the chessboard.
+ * @param k         The length of the partial solutions, 1 <= k < n.
+ * @param shard     The shard to select.
+ * @param manifest  Filled with the description of the shard.
+ * @returns         The shard's partial solutions in lexicographic order, concatenated.
+ */
+std::vector<unsigned int> shard_prefixes(unsigned int n, unsigned int k, const Shard& shard, ShardManifest& manifest);
+
+/**
+ * @brief Returns the path of the manifest belonging to a shard's solution file.
+ */
+std::string shard_manifest_path(const std::string& solution_path);
+
+/**
+ * @brief Writes a manifest as a single text line.  Returns false if it could not be written.
+ */
+bool write_shard_manifest(const std::string& path, const ShardManifest& manifest);
+
+/**
+ * @brief Reads a manifest written by write_shard_manifest().  Returns false on errors.
+ */
+bool read_shard_manifest(const std::string& path, ShardManifest& manifest);
+
+#endif // NQUEENS_SHARD_H
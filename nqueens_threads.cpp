@@ -0,0 +1,539 @@
+/**
+ * @file    nqueens_threads.cpp
+ * @brief   Implements the multithreaded nqueens solver pool.
+ */
+
+#include "nqueens_threads.h"
+
+#include <memory>
+#include <algorithm>
+#include "nqueens.h"
+#include "solution_iterator.h"
+#include "huge_pages.h"
+
+// stores the solutions found by the current thread.  Every solver thread has its own copy,
+// so the callbacks passed to nqueens_by_level need no locking
+struct LocalSolutions
+{
+    static std::vector<unsigned int>& solutions()
+    {
+        static thread_local std::vector<unsigned int> sols;
+        return sols;
+    }
+    static unsigned long long& count()
+    {
+        static thread_local unsigned long long num_sols;
+        return num_sols;
+    }
+    //the node of a pinned solver thread, 0 otherwise
+    static unsigned int& node()
+    {
+        static thread_local unsigned int thread_node;
+        return thread_node;
+    }
+    //the reducer of the task running on this thread, in reduce()
+    static Reducer*& reducer()
+    {
+        static thread_local Reducer* current;
+        return current;
+    }
+    static void add_solution(const std::vector<unsigned int>& sol)
+    {
+        solutions().insert(solutions().end(), sol.begin(), sol.end());
+        ++count();
+    }
+    static void clear_solutions()
+    {
+        solutions().clear();
+        count() = 0;
+    }
+};
+
+//callback used in count mode: only the number of solutions is kept
+void count_solution_callback(std::vector<unsigned int>&)
+{
+    ++LocalSolutions::count();
+}
+
+//callback used in all mode and for collecting the partial solutions of the first k levels
+void store_solution_callback(std::vector<unsigned int>& solution)
+{
+    LocalSolutions::add_solution(solution);
+}
+
+//callback used by reduce(): the solution goes into the reducer of the running task
+void accumulate_solution_callback(std::vector<unsigned int>& solution)
+{
+    LocalSolutions::reducer()->accumulate(solution.data());
+}
+
+//the state shared by all tasks of one query
+struct QueryState
+{
+    unsigned int n, k;
+    Solve_Mode mode;
+    bool general; //solve `problem` instead of the plain n-queens problem
+    Problem problem;
+    std::vector<unsigned int> prefixes; //all partial solutions of length k, concatenated
+    std::vector<unsigned long long> counts; //number of solutions found per prefix
+    std::vector<std::vector<unsigned int> > solutions; //solutions found per prefix
+    std::vector<unsigned int> nodes; //the node of the thread that solved each prefix
+    size_t first_found; //lowest prefix index with a solution (first mode only)
+    size_t remaining; //tasks not completed yet; with a sink, prefixes not handed to it yet
+    SolutionSink* sink; //receives the solutions in prefix order, or NULL to collect them
+    std::vector<char> solved; //with a sink: the prefixes whose task completed
+    size_t next_sunk; //with a sink: the first prefix not handed to it yet
+    bool sinking; //with a sink: a thread is handing prefixes to it
+    std::mutex state_mutex;
+    std::condition_variable done;
+};
+
+//the completion state of the tasks submitted by one run_tasks() or run_on_nodes() call
+struct TaskGroup
+{
+    size_t remaining;
+    std::mutex state_mutex;
+    std::condition_variable done;
+};
+
+/**
+ * @brief Completes the partial solution `index` of the given query on the calling thread.
+ */
+void solve_prefix(QueryState& query, size_t index)
+{
+    if(query.mode == first_mode)
+    {
+        //a prefix earlier in lexicographic order already has a solution, so this subtree cannot contain the first one
+        std::lock_guard<std::mutex> lock(query.state_mutex);
+        if(query.first_found < index) return;
+    }
+
+    std::vector<unsigned int> pos(query.n);
+    std::copy(query.prefixes.begin() + index * query.k, query.prefixes.begin() + (index + 1) * query.k, pos.begin());
+
+    LocalSolutions::clear_solutions();
+    if(query.general)
+    {
+        //the bit mask engine of the general problems, which also stops early in first mode
+        SolutionIterator solutions(query.problem, pos.data(), query.k, query.n);
+        while(solutions.next())
+        {
+            if(query.mode == count_mode) ++LocalSolutions::count();
+            else LocalSolutions::add_solution(std::vector<unsigned int>(solutions.solution(), solutions.solution() + query.n));
+            if(query.mode == first_mode) break;
+        }
+    }
+    else if(query.mode == count_mode) nqueens_by_level(pos, query.k, query.n, &count_solution_callback);
+    else if(query.mode == first_mode)
+    {
+        //nqueens_by_level cannot stop early, the iterator stops after the first solution of the subtree
+        SolutionIterator solutions(query.n, pos.data(), query.k);
+        if(solutions.next()) LocalSolutions::add_solution(std::vector<unsigned int>(solutions.solution(), solutions.solution() + query.n));
+    }
+    else nqueens_by_level(pos, query.k, query.n, &store_solution_callback);
+
+    //the buffer was first touched by this thread, so it stays on its node until the merge
+    query.counts[index] = LocalSolutions::count();
+    query.solutions[index].swap(LocalSolutions::solutions());
+    query.nodes[index] = LocalSolutions::node();
+    LocalSolutions::clear_solutions();
+
+    if(query.mode == first_mode && query.counts[index] > 0)
+    {
+        std::lock_guard<std::mutex> lock(query.state_mutex);
+        if(index < query.first_found) query.first_found = index;
+    }
+}
+
+/**
+ * @brief Marks the prefix `index` as solved and hands all solved prefixes
+ *        that follow the ones already handed over to the query's sink.  Only
+ *        one thread does so at a time, the others leave their prefix to it.
+ *        Requires the query's state_mutex to be held by `lock`.
+ */
+void sink_prefixes(QueryState& query, size_t index, std::unique_lock<std::mutex>& lock)
+{
+    query.solved[index] = true;
+    if(query.sinking) return;
+    query.sinking = true;
+    while(query.next_sunk < query.solved.size() && query.solved[query.next_sunk])
+    {
+        std::vector<unsigned int> solutions;
+        solutions.swap(query.solutions[query.next_sunk++]);
+        lock.unlock();
+        if(!solutions.empty()) query.sink->add_solutions(solutions.data(), solutions.data() + solutions.size());
+        lock.lock();
+        if(--query.remaining == 0) query.done.notify_all();
+    }
+    query.sinking = false;
+}
+
+/**
+ * @brief Copies the solutions of the prefixes solved on `node` (or of all
+ *        prefixes, for a negative node) to their place in `merged`, frees
+ *        their buffers and counts where the buffers were.
+ */
+void merge_prefixes(QueryState& query, int node, const std::vector<size_t>& offsets, unsigned int* merged,
+                    unsigned long long& local, unsigned long long& remote)
+{
+    int merging_node = current_node();
+    for(size_t i = 0; i < query.solutions.size(); ++i)
+    {
+        std::vector<unsigned int>& solutions = query.solutions[i];
+        if((node >= 0 && query.nodes[i] != (unsigned int) node) || solutions.empty()) continue;
+        int buffer_node = page_node(solutions.data());
+        if(buffer_node >= 0 && merging_node >= 0) (buffer_node == merging_node ? local : remote) += solutions.size();
+        std::copy(solutions.begin(), solutions.end(), merged + offsets[i]);
+        std::vector<unsigned int>().swap(solutions);
+    }
+}
+
+SolverPool::SolverPool(unsigned int num_threads, bool pin) : pin_threads(pin), num_nodes(1), stopping(false)
+{
+    if(num_threads == 0) num_threads = 1;
+    if(pin_threads)
+    {
+        placement = place_threads(cpu_topology(), num_threads);
+        num_nodes = std::min<unsigned int>(num_threads, std::max(1u, cpu_topology().num_nodes()));
+    }
+    node_tasks.resize(num_nodes);
+    for(unsigned int i = 0; i < num_threads; ++i)
+        threads.push_back(std::thread(&SolverPool::run_worker, this, i));
+}
+
+SolverPool::~SolverPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        stopping = true;
+    }
+    tasks_available.notify_all();
+    for(size_t i = 0; i < threads.size(); ++i) threads[i].join();
+}
+
+void SolverPool::submit(const std::function<void()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        tasks.push_back(task);
+    }
+    tasks_available.notify_one();
+}
+
+void SolverPool::submit_to_node(unsigned int node, const std::function<void()>& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        node_tasks[node].push_back(task);
+    }
+    //only the threads of the node can take it
+    tasks_available.notify_all();
+}
+
+void SolverPool::run_worker(unsigned int thread)
+{
+    //pinned before the thread allocates anything, so that its buffers are first touched on its node
+    unsigned int node = 0;
+    if(pin_threads)
+    {
+        node = placement[thread].node;
+        pin_current_thread(placement[thread].cpu);
+    }
+    LocalSolutions::node() = node;
+    while(true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(tasks_mutex);
+            while(tasks.empty() && node_tasks[node].empty() && !stopping) tasks_available.wait(lock);
+            std::deque<std::function<void()> >& queue = node_tasks[node].empty() ? tasks : node_tasks[node];
+            if(queue.empty()) return; //stopping and no work left
+            task = queue.front();
+            queue.pop_front();
+        }
+        task();
+    }
+}
+
+/**
+ * @brief Generates all partial solutions of the first k levels on the calling thread, concatenated.
+ */
+std::vector<unsigned int> first_levels(const Problem* problem, unsigned int n, unsigned int k)
+{
+    std::vector<unsigned int> pos(n);
+    LocalSolutions::clear_solutions();
+    if(problem != NULL) problem_by_level(*problem, pos, 0, k, &store_solution_callback);
+    else nqueens_by_level(pos, 0, k, &store_solution_callback);
+    std::vector<unsigned int> prefixes;
+    prefixes.swap(LocalSolutions::solutions());
+    LocalSolutions::clear_solutions();
+    return prefixes;
+}
+
+SolveResult SolverPool::solve(unsigned int n, unsigned int k, Solve_Mode mode)
+{
+    SolveResult result;
+    result.n = n;
+    result.count = 0;
+    if(n == 0) return result;
+
+    //the workers need at least one level left to solve, and the prefixes need at least one level
+    if(k >= n) k = n - 1;
+    if(k == 0)
+    {
+        //n == 1, nothing to split
+        result.count = 1;
+        if(mode != count_mode) result.solutions.push_back(0);
+        return result;
+    }
+
+    return solve_prefixes(NULL, n, k, mode, first_levels(NULL, n, k), NULL);
+}
+
+SolveResult SolverPool::solve(unsigned int n, unsigned int k, SolutionSink& sink)
+{
+    SolveResult result;
+    result.n = n;
+    result.count = 0;
+    if(n == 0) return result;
+
+    if(k >= n) k = n - 1;
+    if(k == 0)
+    {
+        //n == 1, nothing to split
+        unsigned int solution = 0;
+        sink.add_solutions(&solution, &solution + 1);
+        result.count = 1;
+        return result;
+    }
+
+    return solve_prefixes(NULL, n, k, all_mode, first_levels(NULL, n, k), &sink);
+}
+
+SolveResult SolverPool::solve(const Problem& problem, unsigned int k, Solve_Mode mode)
+{
+    unsigned int n = problem.n;
+    if(k >= n) k = n - 1;
+    if(k == 0)
+    {
+        //n <= 1, nothing to split
+        SolveResult result;
+        result.n = n;
+        std::vector<unsigned int> solutions = solve_problem(problem);
+        result.solutions.assign(solutions.begin(), solutions.end());
+        if(mode == first_mode) result.solutions.resize(std::min<size_t>(result.solutions.size(), n));
+        result.count = n > 0 ? result.solutions.size() / n : 0;
+        if(mode == count_mode) result.solutions.clear();
+        return result;
+    }
+
+    return solve_prefixes(&problem, n, k, mode, first_levels(&problem, n, k), NULL);
+}
+
+SolveResult SolverPool::solve(const Problem& problem, unsigned int k, SolutionSink& sink)
+{
+    unsigned int n = problem.n;
+    if(k >= n) k = n - 1;
+    if(k == 0)
+    {
+        //n <= 1, nothing to split
+        SolveResult result;
+        result.n = n;
+        std::vector<unsigned int> solutions = solve_problem(problem);
+        if(!solutions.empty()) sink.add_solutions(solutions.data(), solutions.data() + solutions.size());
+        result.count = n > 0 ? solutions.size() / n : 0;
+        return result;
+    }
+
+    return solve_prefixes(&problem, n, k, all_mode, first_levels(&problem, n, k), &sink);
+}
+
+void SolverPool::reduce(unsigned int n, unsigned int k, Reducer& reducer)
+{
+    //the workers need at least one level left to solve, and the prefixes need at least one level
+    if(k >= n) k = n > 0 ? n - 1 : 0;
+    if(k == 0)
+    {
+        //n <= 1, nothing to split
+        reduce_sequential(n, reducer);
+        return;
+    }
+    reduce_prefixes(NULL, n, k, first_levels(NULL, n, k), reducer);
+}
+
+void SolverPool::reduce(const Problem& problem, unsigned int k, Reducer& reducer)
+{
+    unsigned int n = problem.n;
+    if(k >= n) k = n > 0 ? n - 1 : 0;
+    if(k == 0)
+    {
+        reduce_sequential(problem, reducer);
+        return;
+    }
+    reduce_prefixes(&problem, n, k, first_levels(&problem, n, k), reducer);
+}
+
+void SolverPool::reduce_prefixes(const Problem* problem, unsigned int n, unsigned int k,
+                                 const std::vector<unsigned int>& prefixes, Reducer& reducer)
+{
+    reducer.init(n);
+    std::mutex reducer_mutex;
+    run_tasks(prefixes.size() / k, [&](size_t index) {
+        std::unique_ptr<Reducer> local(create_reducer(reducer.type()));
+        local->init(n);
+        std::vector<unsigned int> pos(n);
+        std::copy(prefixes.begin() + index * k, prefixes.begin() + (index + 1) * k, pos.begin());
+        if(problem != NULL)
+        {
+            SolutionIterator solutions(*problem, pos.data(), k, n);
+            while(solutions.next()) local->accumulate(solutions.solution());
+        }
+        else
+        {
+            LocalSolutions::reducer() = local.get();
+            nqueens_by_level(pos, k, n, &accumulate_solution_callback);
+            LocalSolutions::reducer() = NULL;
+        }
+
+        //the reducers are commutative, so the tasks merge in any order, like the states sent by MPI workers
+        std::vector<unsigned int> state;
+        local->serialize(state);
+        std::lock_guard<std::mutex> lock(reducer_mutex);
+        reducer.merge(state.data(), state.size());
+    });
+}
+
+SolveResult SolverPool::solve_prefixes(unsigned int n, unsigned int k, Solve_Mode mode, const std::vector<unsigned int>& prefixes)
+{
+    return solve_prefixes(NULL, n, k, mode, prefixes, NULL);
+}
+
+SolveResult SolverPool::solve_prefixes(unsigned int n, unsigned int k, const std::vector<unsigned int>& prefixes,
+                                       SolutionSink& sink)
+{
+    return solve_prefixes(NULL, n, k, all_mode, prefixes, &sink);
+}
+
+SolveResult SolverPool::solve_prefixes(const Problem* problem, unsigned int n, unsigned int k, Solve_Mode mode,
+                                       const std::vector<unsigned int>& prefixes, SolutionSink* sink)
+{
+    SolveResult result;
+    result.n = n;
+    result.count = 0;
+
+    std::shared_ptr<QueryState> query = std::make_shared<QueryState>();
+    query->n = n;
+    query->k = k;
+    query->mode = mode;
+    query->general = problem != NULL;
+    if(problem != NULL) query->problem = *problem;
+    query->prefixes = prefixes;
+
+    size_t num_prefixes = query->prefixes.size() / k;
+    query->counts.assign(num_prefixes, 0);
+    query->solutions.resize(num_prefixes);
+    query->nodes.assign(num_prefixes, 0);
+    query->first_found = num_prefixes;
+    query->remaining = num_prefixes;
+    query->sink = sink;
+    if(sink != NULL) query->solved.assign(num_prefixes, false);
+    query->next_sunk = 0;
+    query->sinking = false;
+
+    for(size_t i = 0; i < num_prefixes; ++i)
+    {
+        submit([query, i]() {
+            solve_prefix(*query, i);
+            std::unique_lock<std::mutex> lock(query->state_mutex);
+            if(query->sink != NULL) sink_prefixes(*query, i, lock);
+            else if(--query->remaining == 0) query->done.notify_all();
+        });
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(query->state_mutex);
+        while(query->remaining > 0) query->done.wait(lock);
+    }
+
+    //concatenating the per prefix results keeps the order of the prefixes
+    if(mode == first_mode)
+    {
+        if(query->first_found < num_prefixes)
+        {
+            result.count = 1;
+            result.solutions.assign(query->solutions[query->first_found].begin(), query->solutions[query->first_found].end());
+        }
+        return result;
+    }
+    result.prefix_counts = query->counts;
+    if(sink != NULL)
+    {
+        for(size_t i = 0; i < num_prefixes; ++i) result.count += query->counts[i];
+        return result;
+    }
+    std::vector<size_t> offsets(num_prefixes + 1, 0);
+    for(size_t i = 0; i < num_prefixes; ++i)
+    {
+        result.count += query->counts[i];
+        offsets[i + 1] = offsets[i] + query->solutions[i].size();
+    }
+    //sized without writing: the huge page advice of reserve_huge() holds and every page is first touched by the merge
+    reserve_huge(result.solutions, offsets[num_prefixes]);
+    result.solutions.resize(offsets[num_prefixes]);
+    if(num_nodes == 1)
+    {
+        merge_prefixes(*query, -1, offsets, result.solutions.data(), result.merged_local, result.merged_remote);
+        return result;
+    }
+    //every node copies the buffers it wrote, so they are only read on their own node, and first touches, so
+    //places, its own ranges of the result
+    std::vector<unsigned long long> local(num_nodes, 0), remote(num_nodes, 0);
+    unsigned int* merged = result.solutions.data();
+    run_on_nodes([&](unsigned int node) {
+        merge_prefixes(*query, node, offsets, merged, local[node], remote[node]);
+    });
+    for(unsigned int node = 0; node < num_nodes; ++node)
+    {
+        result.merged_local += local[node];
+        result.merged_remote += remote[node];
+    }
+    return result;
+}
+
+void SolverPool::run_tasks(size_t num_tasks, const std::function<void(size_t)>& task)
+{
+    std::shared_ptr<TaskGroup> group = std::make_shared<TaskGroup>();
+    group->remaining = num_tasks;
+    for(size_t i = 0; i < num_tasks; ++i)
+    {
+        submit([group, task, i]() {
+            task(i);
+            std::lock_guard<std::mutex> lock(group->state_mutex);
+            if(--group->remaining == 0) group->done.notify_all();
+        });
+    }
+    std::unique_lock<std::mutex> lock(group->state_mutex);
+    while(group->remaining > 0) group->done.wait(lock);
+}
+
+void SolverPool::run_on_nodes(const std::function<void(unsigned int)>& task)
+{
+    std::shared_ptr<TaskGroup> group = std::make_shared<TaskGroup>();
+    group->remaining = num_nodes;
+    for(unsigned int node = 0; node < num_nodes; ++node)
+    {
+        submit_to_node(node, [group, task, node]() {
+            task(node);
+            std::lock_guard<std::mutex> lock(group->state_mutex);
+            if(--group->remaining == 0) group->done.notify_all();
+        });
+    }
+    std::unique_lock<std::mutex> lock(group->state_mutex);
+    while(group->remaining > 0) group->done.wait(lock);
+}
+
+unsigned int default_num_threads()
+{
+    unsigned int num_threads = std::thread::hardware_concurrency();
+    return num_threads > 0 ? num_threads : 1;
+}
@@ -0,0 +1,167 @@
+/**
+ * @file    nqueens_threads.h
+ * @brief   Declares the multithreaded nqueens solver: a pool of long running
+ *          worker threads that complete partial solutions generated by the
+ *          caller, using the same prefix decomposition as the MPI solver.
+ *
+ * Every thread collects its solutions in buffers of its own.  With pinned
+ * threads (see cpu_topology.h) those buffers are first touched, and so
+ * allocated, on the NUMA node of the thread, and the results are merged by
+ * one task per node that only reads the buffers of its own node.
+ */
+
+#ifndef NQUEENS_THREADS_H
+#define NQUEENS_THREADS_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "nqueens_mode.h"
+#include "problem.h"
+#include "reducer.h"
+#include "solution_sink.h"
+#include "solution_buffer.h"
+#include "cpu_topology.h"
+
+/**
+ * @brief The answer to a single (n, mode) query.
+ *
+ * `count` is the total number of solutions for count and all mode, and 0 or 1
+ * for first mode.  `solutions` holds `count` concatenated solutions of `n`
+ * integers each in lexicographic order (empty in count mode), in a
+ * SolutionBuffer, so the merge of all mode sizes it without writing it first.
+ * `prefix_counts` holds the number of solutions below every partial solution
+ * the query was split into, in order (count and all mode).
+ * `merged_local` and `merged_remote` count the solution values that the
+ * merge of all mode read from buffers on the merging thread's NUMA node and
+ * on other nodes (values whose node is unknown are not counted).
+ */
+struct SolveResult
+{
+    unsigned int n;
+    unsigned long long count;
+    SolutionBuffer solutions;
+    std::vector<unsigned long long> prefix_counts;
+    unsigned long long merged_local = 0, merged_remote = 0;
+};
+
+/**
+ * @brief A fixed set of solver threads that is kept alive between queries.
+ *
+ * Each query is split into the partial solutions of its first `k` levels and
+ * every partial solution becomes one task in the shared task queue.  Tasks of
+ * concurrent queries are interleaved in the same queue, so the threads stay
+ * busy as long as any query is outstanding.
+ */
+class SolverPool
+{
+public:
+    /**
+     * @param pin_threads  Pin every thread to a CPU, spread over the NUMA
+     *                     nodes by place_threads(), and merge per node.
+     */
+    explicit SolverPool(unsigned int num_threads, bool pin_threads = false);
+    ~SolverPool();
+
+    unsigned int num_threads() const { return threads.size(); }
+    bool pinned() const { return pin_threads; }
+    //where the threads run, when they are pinned
+    const std::vector<ThreadPlacement>& thread_placement() const { return placement; }
+
+    /**
+     * @brief Solves the n-queens problem in the given mode and blocks until the result is complete.
+     *
+     * @param n     The size of the chessboard.
+     * @param k     The number of levels solved by the caller before handing
+     *              the partial solutions to the pool (clamped to [1, n-1]).
+     * @param mode  What to compute.
+     */
+    SolveResult solve(unsigned int n, unsigned int k, Solve_Mode mode);
+
+    /**
+     * @brief Completes the given partial solutions in the given mode and blocks until the result is complete.
+     *
+     * @param prefixes  Concatenated partial solutions of `k` levels each,
+     *                  with 1 <= k < n.  The result lists the solutions of
+     *                  each prefix in the order of the prefixes.
+     */
+    SolveResult solve_prefixes(unsigned int n, unsigned int k, Solve_Mode mode, const std::vector<unsigned int>& prefixes);
+
+    /**
+     * @brief Solves a general problem (see problem.h) in the given mode, split like solve().
+     */
+    SolveResult solve(const Problem& problem, unsigned int k, Solve_Mode mode);
+
+    /**
+     * @brief Solves all mode like solve(), but hands the solutions to `sink`
+     *        (see solution_sink.h) in order while the tasks complete, instead
+     *        of collecting them.  Only the solutions of prefixes that complete
+     *        ahead of an earlier one are held back until it is done.
+     *
+     * The sink is called by one solver thread at a time.  The result holds
+     * the count and prefix counts, but no solutions.
+     */
+    SolveResult solve(unsigned int n, unsigned int k, SolutionSink& sink);
+
+    /**
+     * @brief Solves a general problem in all mode into `sink`, like solve(n, k, sink).
+     */
+    SolveResult solve(const Problem& problem, unsigned int k, SolutionSink& sink);
+
+    /**
+     * @brief Completes the given partial solutions in all mode into `sink`, like solve(n, k, sink).
+     */
+    SolveResult solve_prefixes(unsigned int n, unsigned int k, const std::vector<unsigned int>& prefixes, SolutionSink& sink);
+
+    /**
+     * @brief Reduces all solutions of the n-queens problem into `reducer` (see reducer.h), split like solve().
+     *
+     * Every task accumulates the solutions below its partial solution into a
+     * reducer of its own and merges that into `reducer` when it completes, so
+     * no solutions are collected.  `reducer` is initialized for n first.
+     */
+    void reduce(unsigned int n, unsigned int k, Reducer& reducer);
+
+    /**
+     * @brief Reduces all solutions of a general problem, split like solve().
+     */
+    void reduce(const Problem& problem, unsigned int k, Reducer& reducer);
+
+    /**
+     * @brief Runs task(0), task(1), ..., task(num_tasks - 1) on the solver
+     *        threads, interleaved with the tasks of other queries, and blocks
+     *        until all of them are complete.
+     */
+    void run_tasks(size_t num_tasks, const std::function<void(size_t)>& task);
+
+private:
+    SolveResult solve_prefixes(const Problem* problem, unsigned int n, unsigned int k, Solve_Mode mode,
+                               const std::vector<unsigned int>& prefixes, SolutionSink* sink);
+    void reduce_prefixes(const Problem* problem, unsigned int n, unsigned int k, const std::vector<unsigned int>& prefixes,
+                         Reducer& reducer);
+    void run_worker(unsigned int thread);
+    void submit(const std::function<void()>& task);
+    void submit_to_node(unsigned int node, const std::function<void()>& task);
+    void run_on_nodes(const std::function<void(unsigned int)>& task);
+
+    std::vector<std::thread> threads;
+    bool pin_threads;
+    std::vector<ThreadPlacement> placement;
+    unsigned int num_nodes; //the nodes that have threads; 1 without pinning
+    std::deque<std::function<void()> > tasks;
+    std::vector<std::deque<std::function<void()> > > node_tasks; //per node: tasks only its threads run
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_available;
+    bool stopping;
+};
+
+/**
+ * @brief Returns the number of solver threads to use when none is given explicitly.
+ */
+unsigned int default_num_threads();
+
+#endif // NQUEENS_THREADS_H
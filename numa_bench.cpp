@@ -0,0 +1,93 @@
+/**
+ * @file    numa_bench.cpp
+ * @brief   Implements a benchmark of the solver pool with and without
+ *          NUMA pinning: the run time of an all-solutions query and how much
+ *          of its merge read solution buffers on another node.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <chrono>
+
+#include "nqueens_threads.h"
+#include "cpu_topology.h"
+
+
+/**
+ * Prints the usage of the program.
+ */
+void print_usage() {
+    std::cerr << "Usage: ./nqueens-numa-bench [options] <n> <k>" << std::endl;
+    std::cerr << "      Required arguments:" << std::endl;
+    std::cerr << "          <n>     The size of the chess board." << std::endl;
+    std::cerr << "          <k>     The number of levels split into tasks." << std::endl;
+    std::cerr << "      Optional arguments:" << std::endl;
+    std::cerr << "          -j <p>  Number of solver threads (default: number of cores)." << std::endl;
+    std::cerr << "          -r <r>  Number of runs of each configuration (default: 3)." << std::endl;
+    std::cerr << "      Example:" << std::endl;
+    std::cerr << "          ./nqueens-numa-bench -j 32 14 4" << std::endl;
+}
+
+/**
+ * @brief Runs the query `runs` times on a pool and prints one line per run.
+ */
+void run_config(const char* name, bool pin, unsigned int num_threads, unsigned int n, unsigned int k, unsigned int runs)
+{
+    SolverPool pool(num_threads, pin);
+    for (unsigned int run = 0; run < runs; ++run) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        SolveResult result = pool.solve(n, k, all_mode);
+        double time_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double local_mb = result.merged_local * sizeof(unsigned int) / 1e6;
+        double remote_mb = result.merged_remote * sizeof(unsigned int) / 1e6;
+        printf("%-9s %4u %12llu %10.0lf %12.1lf %12.1lf\n", name, run, result.count, time_secs * 1000.0, local_mb, remote_mb);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int num_threads = default_num_threads();
+    unsigned int runs = 3;
+
+    // forget about first argument (which is the executable's name)
+    argc--;
+    argv++;
+
+    // parse optional parameters
+    while (argc > 1 && argv[0][0] == '-') {
+        switch (argv[0][1]) {
+            case 'j':
+                num_threads = atoi(argv[1]);
+                break;
+            case 'r':
+                runs = atoi(argv[1]);
+                break;
+            default:
+                print_usage();
+                exit(EXIT_FAILURE);
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 2 || num_threads == 0 || runs == 0) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+    int n = atoi(argv[0]);
+    int k = atoi(argv[1]);
+    if (n < 4 || k <= 0 || k >= n) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    const CpuTopology& topology = cpu_topology();
+    std::cerr << topology.num_nodes() << " NUMA nodes, " << topology.num_cpus() << " usable cpus; pinned layout:" << std::endl;
+    print_placement(std::cerr, topology, place_threads(topology, num_threads));
+
+    // the merge reads every solution once: from the caller's node when unpinned, from the writer's node when pinned
+    printf("%-9s %4s %12s %10s %12s %12s\n", "config", "run", "solutions", "time_ms", "local_MB", "remote_MB");
+    run_config("unpinned", false, num_threads, n, k, runs);
+    run_config("pinned", true, num_threads, n, k, runs);
+    return 0;
+}
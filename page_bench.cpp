@@ -0,0 +1,133 @@
+/**
+ * @file    page_bench.cpp
+ * @brief   Implements a benchmark of the solution buffers with and without
+ *          huge pages: the page faults and time of collecting solutions.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iostream>
+#include <chrono>
+
+#include "huge_pages.h"
+#include "solution_sink.h"
+#include "nqueens_threads.h"
+
+
+/**
+ * Prints the usage of the program.
+ */
+void print_usage() {
+    std::cerr << "Usage: ./nqueens-page-bench [options] [<n> <k>]" << std::endl;
+    std::cerr << "      Without <n> and <k>, streams synthetic solutions into a solution sink;" << std::endl;
+    std::cerr << "      with them, collects all solutions of the n-queens problem on the solver pool." << std::endl;
+    std::cerr << "      Optional arguments:" << std::endl;
+    std::cerr << "          -m <MB>  Megabytes of synthetic solutions (default: 512)." << std::endl;
+    std::cerr << "          -j <p>   Number of solver threads (default: number of cores)." << std::endl;
+    std::cerr << "      Example:" << std::endl;
+    std::cerr << "          ./nqueens-page-bench -m 1024" << std::endl;
+    std::cerr << "          ./nqueens-page-bench -j 8 15 4" << std::endl;
+}
+
+/**
+ * @brief Returns the minor page faults of the process so far.
+ */
+long minor_faults()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+/**
+ * @brief Returns the kB of anonymous memory of the process in transparent huge pages, -1 if unknown.
+ */
+long anon_huge_kb()
+{
+    std::ifstream file("/proc/self/smaps_rollup");
+    std::string key;
+    long kb;
+    while (file >> key) {
+        if (key == "AnonHugePages:" && file >> kb)
+            return kb;
+        file.ignore(1 << 20, '\n');
+    }
+    return -1;
+}
+
+/**
+ * @brief Collects the solutions once and prints one line of measurements.
+ */
+void run_config(const char* name, bool huge, size_t megabytes, unsigned int n, unsigned int k, SolverPool& pool)
+{
+    set_huge_pages_enabled(huge);
+    long faults = minor_faults();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<unsigned int> solutions;
+    SolveResult result;
+    if (n > 0) {
+        result = pool.solve(n, k, all_mode);
+    } else {
+        // chunks of the size of a worker's result message
+        std::vector<unsigned int> chunk(16384);
+        for (size_t i = 0; i < chunk.size(); ++i)
+            chunk[i] = i % 16;
+        VectorSolutionSink sink(solutions);
+        size_t chunks = megabytes * 1000000 / (chunk.size() * sizeof(unsigned int));
+        for (size_t i = 0; i < chunks; ++i)
+            sink.add_solutions(chunk.data(), chunk.data() + chunk.size());
+    }
+    double time_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    faults = minor_faults() - faults;
+    size_t values = n > 0 ? result.solutions.size() : solutions.size();
+    printf("%-7s %10.1lf %12ld %10.0lf %12ld\n", name, values * sizeof(unsigned int) / 1e6, faults,
+           time_secs * 1000.0, anon_huge_kb() / 1024);
+}
+
+int main(int argc, char *argv[]) {
+    size_t megabytes = 512;
+    unsigned int num_threads = default_num_threads();
+
+    // forget about first argument (which is the executable's name)
+    argc--;
+    argv++;
+
+    // parse optional parameters
+    while (argc > 1 && argv[0][0] == '-') {
+        switch (argv[0][1]) {
+            case 'm':
+                megabytes = atol(argv[1]);
+                break;
+            case 'j':
+                num_threads = atoi(argv[1]);
+                break;
+            default:
+                print_usage();
+                exit(EXIT_FAILURE);
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    int n = 0, k = 0;
+    if (argc == 2) {
+        n = atoi(argv[0]);
+        k = atoi(argv[1]);
+    }
+    if ((argc != 0 && argc != 2) || (argc == 2 && (n < 4 || k <= 0 || k >= n)) || megabytes == 0 || num_threads == 0) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    std::string mode = transparent_huge_page_mode();
+    std::cerr << "Transparent huge pages: " << (mode.empty() ? "unavailable" : mode) << std::endl;
+    SolverPool pool(num_threads);
+    printf("%-7s %10s %12s %10s %12s\n", "pages", "MB", "page_faults", "time_ms", "huge_MB");
+    run_config("normal", false, megabytes, n, k, pool);
+    run_config("huge", true, megabytes, n, k, pool);
+    return 0;
+}
@@ -25,5 +25,7 @@ N=10
 #for p in 8 16 32
 #do
 p=6
-    $MPIRUN -np $p --hostfile $PBS_NODEFILE ./nqueens -o $N $MASTER_DEPTH
+    # -B binds every rank to its own core (the master to one without workers)
+    # and prints the layout; mpirun must leave the ranks unbound for that
+    $MPIRUN -np $p --hostfile $PBS_NODEFILE --bind-to none ./nqueens -B -o $N $MASTER_DEPTH
 #done
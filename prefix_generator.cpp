@@ -0,0 +1,143 @@
+/**
+ * @file    prefix_generator.cpp
+ * @brief   Implements the parallel generation of the master's partial solutions.
+ */
+
+#include "prefix_generator.h"
+
+#include <algorithm>
+#include "nqueens.h"
+#include "solution_iterator.h"
+
+//the first chunk of a subtree is small, so the master can start dispatching early; later ones grow up to the maximum
+const size_t first_chunk_prefixes = 64;
+const size_t max_chunk_prefixes = 8192;
+
+struct PrefixThreads
+{
+    static unsigned int& num_threads()
+    {
+        static unsigned int threads = 1;
+        return threads;
+    }
+};
+
+void set_prefix_threads(unsigned int num_threads)
+{
+    PrefixThreads::num_threads() = std::max(num_threads, 1u);
+}
+
+unsigned int prefix_threads()
+{
+    return PrefixThreads::num_threads();
+}
+
+PrefixGenerator::PrefixGenerator(const Problem& board, unsigned int levels, unsigned int num_threads)
+    : problem(board), k(levels), split_depth(levels >= 3 ? 2 : 1), next_subtree(0), current_subtree(0),
+      stopping(false), chunk_pos(0)
+{
+    //the subtrees are cheap to find on this thread: at most n^2 partial solutions of two rows
+    SolutionIterator it(problem, NULL, 0, split_depth);
+    while(it.next()) roots.insert(roots.end(), it.solution(), it.solution() + split_depth);
+    subtrees.resize(roots.size() / split_depth);
+    for(size_t i = 0; i < subtrees.size(); ++i) subtrees[i].done = false;
+
+    //enough subtrees ahead of the master to keep every thread busy while the master works through one
+    num_threads = std::max(num_threads, 1u);
+    window = 4 * num_threads;
+    for(unsigned int i = 0; i < num_threads; ++i) threads.push_back(std::thread(&PrefixGenerator::run_generator, this));
+}
+
+PrefixGenerator::~PrefixGenerator()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    window_moved.notify_all();
+    for(size_t i = 0; i < threads.size(); ++i) threads[i].join();
+}
+
+void PrefixGenerator::run_generator()
+{
+    std::vector<unsigned int> buffer;
+    while(true)
+    {
+        size_t subtree;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!stopping && next_subtree < subtrees.size() && next_subtree >= current_subtree + window)
+                window_moved.wait(lock);
+            if(stopping || next_subtree >= subtrees.size()) return;
+            subtree = next_subtree++;
+        }
+
+        size_t chunk_prefixes = first_chunk_prefixes;
+        buffer.clear();
+        SolutionIterator it(problem, &roots[subtree * split_depth], split_depth, k);
+        bool more = true;
+        while(more)
+        {
+            more = it.next();
+            if(more) buffer.insert(buffer.end(), it.solution(), it.solution() + k);
+            if(more && buffer.size() < chunk_prefixes * k) continue;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!buffer.empty())
+            {
+                subtrees[subtree].chunks.push_back(std::vector<unsigned int>());
+                subtrees[subtree].chunks.back().swap(buffer);
+            }
+            subtrees[subtree].done = !more;
+            //only the master waits, and only for its current subtree
+            if(subtree == current_subtree) chunk_ready.notify_one();
+            if(stopping) return;
+            chunk_prefixes = std::min(2 * chunk_prefixes, max_chunk_prefixes);
+        }
+    }
+}
+
+bool PrefixGenerator::next(std::vector<unsigned int>& prefix)
+{
+    while(chunk_pos >= chunk.size())
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(current_subtree >= subtrees.size()) return false;
+        Subtree& subtree = subtrees[current_subtree];
+        while(subtree.chunks.empty() && !subtree.done) chunk_ready.wait(lock);
+        if(!subtree.chunks.empty())
+        {
+            chunk.swap(subtree.chunks.front());
+            subtree.chunks.pop_front();
+            chunk_pos = 0;
+        }
+        else
+        {
+            //the subtree is exhausted: let the threads search one more
+            ++current_subtree;
+            lock.unlock();
+            window_moved.notify_all();
+        }
+    }
+    prefix.resize(k);
+    const unsigned int* source = &chunk[chunk_pos];
+    for(unsigned int i = 0; i < k; ++i) prefix[i] = source[i];
+    chunk_pos += k;
+    return true;
+}
+
+void generate_prefixes(const Problem* problem, unsigned int n, unsigned int k,
+                       void (* const success_func)(std::vector<unsigned int>&))
+{
+    if(prefix_threads() > 1 && k >= 2 && n <= SolutionIterator::max_n)
+    {
+        PrefixGenerator generator(problem != NULL ? *problem : Problem(n), k, prefix_threads());
+        std::vector<unsigned int> prefix(k);
+        while(generator.next(prefix)) success_func(prefix);
+        return;
+    }
+
+    std::vector<unsigned int> pos(n);
+    if(problem != NULL) problem_by_level(*problem, pos, 0, k, success_func);
+    else nqueens_by_level(pos, 0, k, success_func);
+}
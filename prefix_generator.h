@@ -0,0 +1,94 @@
+/**
+ * @file    prefix_generator.h
+ * @brief   Declares the parallel generation of the master's partial solutions.
+ *
+ * For a deep k the master's own search of the first k levels keeps the
+ * workers waiting.  The generator splits this search at the first one or two
+ * rows into subtrees, which its threads search concurrently into chunks of
+ * their own.  The master takes the chunks subtree by subtree, so it sees the
+ * partial solutions in the order of nqueens_by_level() and the tasks keep
+ * their ids.  Only a window of subtrees ahead of the master is searched, so
+ * the buffered partial solutions stay bounded.
+ */
+
+#ifndef PREFIX_GENERATOR_H
+#define PREFIX_GENERATOR_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "problem.h"
+
+class PrefixGenerator
+{
+public:
+    /**
+     * @brief Starts `num_threads` threads that search the partial solutions of
+     *        the first `k` levels of `problem`.  Requires 2 <= k <= problem.n <= 64.
+     */
+    PrefixGenerator(const Problem& problem, unsigned int k, unsigned int num_threads);
+    ~PrefixGenerator();
+
+    /**
+     * @brief Copies the next partial solution, k entries, into `prefix`.
+     *        Returns false once all have been returned.  Called by one thread only.
+     */
+    bool next(std::vector<unsigned int>& prefix);
+
+private:
+    struct Subtree
+    {
+        std::deque<std::vector<unsigned int> > chunks;
+        bool done;
+    };
+
+    void run_generator();
+
+    Problem problem;
+    unsigned int k;
+    unsigned int split_depth;
+    std::vector<unsigned int> roots;   //the partial solutions of the first split_depth rows, one subtree each
+    std::vector<Subtree> subtrees;
+    size_t window;
+
+    //guards the subtrees and the two positions below
+    std::mutex mutex;
+    std::condition_variable chunk_ready;
+    std::condition_variable window_moved;
+    size_t next_subtree;        //the next subtree to be searched
+    size_t current_subtree;     //the subtree the master takes its partial solutions from
+    bool stopping;
+
+    std::vector<unsigned int> chunk;   //the master's current chunk
+    size_t chunk_pos;
+
+    std::vector<std::thread> threads;
+};
+
+/**
+ * @brief Sets the number of threads that generate the master's partial
+ *        solutions (default 1, the master's own thread).
+ */
+void set_prefix_threads(unsigned int num_threads);
+
+/**
+ * @brief Returns the number of threads set by set_prefix_threads().
+ */
+unsigned int prefix_threads();
+
+/**
+ * @brief Calls `success_func` for every partial solution of the first `k`
+ *        levels, in the order of nqueens_by_level(), generated by
+ *        prefix_threads() threads.  Solves the plain n-queens problem if
+ *        `problem` is NULL.
+ *
+ * Falls back to nqueens_by_level() or problem_by_level() on the calling
+ * thread for a single thread, k < 2 or n > 64.
+ */
+void generate_prefixes(const Problem* problem, unsigned int n, unsigned int k,
+                       void (* const success_func)(std::vector<unsigned int>&));
+
+#endif // PREFIX_GENERATOR_H
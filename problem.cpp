@@ -0,0 +1,191 @@
+/**
+ * @file    problem.cpp
+ * @brief   Implements the general problem description and its file format.
+ */
+
+#include "problem.h"
+
+#include <stdlib.h>
+#include <fstream>
+#include <algorithm>
+
+#include "solution_iterator.h"
+
+Problem::Problem(unsigned int board_size, Problem_Variant board_variant)
+    : variant(board_variant), n(board_size), width(board_size), queens(board_size), queen_rows(0)
+{
+    allowed.assign(n, all_columns());
+}
+
+Problem::Problem(unsigned int rows, unsigned int columns, unsigned int num_queens, Problem_Variant board_variant)
+    : variant(board_variant), n(rows), width(columns), queens(num_queens), queen_rows(0)
+{
+    allowed.assign(n, all_columns());
+}
+
+bool Problem::symmetric() const
+{
+    if(rectangular() || queen_rows != 0) return false;
+    for(unsigned int row = 0; row < n; ++row)
+        if(allowed[row] != all_columns()) return false;
+    return true;
+}
+
+bool parse_variant(const std::string& name, Problem_Variant& variant)
+{
+    if(name == "queens") variant = queens_variant;
+    else if(name == "toroidal") variant = toroidal_variant;
+    else if(name == "superqueen") variant = superqueen_variant;
+    else return false;
+    return true;
+}
+
+//serialized as variant, n, width, queens, then queen_rows and the allowed mask of every row as two words, low half first
+void Problem::serialize(std::vector<unsigned int>& words) const
+{
+    words.push_back(variant);
+    words.push_back(n);
+    words.push_back(width);
+    words.push_back(queens);
+    words.push_back(static_cast<unsigned int>(queen_rows));
+    words.push_back(static_cast<unsigned int>(queen_rows >> 32));
+    for(unsigned int row = 0; row < n; ++row)
+    {
+        words.push_back(static_cast<unsigned int>(allowed[row]));
+        words.push_back(static_cast<unsigned int>(allowed[row] >> 32));
+    }
+}
+
+bool Problem::deserialize(const unsigned int* words, size_t size)
+{
+    const size_t header_size = 6;
+    if(size < header_size || words[0] > superqueen_variant || words[1] == 0 || words[1] > max_n || size != header_size + 2 * words[1]
+       || words[2] == 0 || words[2] > max_n || words[3] > std::min(words[1], words[2])
+       || (words[0] == toroidal_variant && words[1] != words[2]))
+        return false;
+    variant = words[0];
+    n = words[1];
+    width = words[2];
+    queens = words[3];
+    queen_rows = (static_cast<uint64_t>(words[5]) << 32) | words[4];
+    allowed.resize(n);
+    for(unsigned int row = 0; row < n; ++row)
+    {
+        const unsigned int* mask = words + header_size + 2 * row;
+        allowed[row] = ((static_cast<uint64_t>(mask[1]) << 32) | mask[0]) & all_columns();
+    }
+    return true;
+}
+
+bool attacks(const Problem& problem, unsigned int row, unsigned int column, unsigned int to_row, unsigned int to_column)
+{
+    if(problem.variant == toroidal_variant)
+    {
+        //on the torus the diagonals are the cells with equal (row - column) or (row + column) modulo n
+        unsigned int n = problem.n;
+        return column == to_column || (row + n - column) % n == (to_row + n - to_column) % n
+               || (row + column) % n == (to_row + to_column) % n;
+    }
+    int rows = abs(static_cast<int>(to_row) - static_cast<int>(row));
+    int columns = abs(static_cast<int>(to_column) - static_cast<int>(column));
+    if(problem.variant == superqueen_variant && rows * columns == 2) return true; //a knight's move
+    return columns == 0 || rows == columns;
+}
+
+bool read_problem_file(const std::string& path, Problem_Variant variant, Problem& problem, std::string& error)
+{
+    std::ifstream file(path.c_str());
+    if(!file)
+    {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<std::string> rows;
+    std::string line;
+    while(std::getline(file, line))
+    {
+        line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+        if(!line.empty() && line[0] != '#') rows.push_back(line);
+    }
+    unsigned int n = rows.size();
+    unsigned int width = n > 0 ? rows[0].size() : 0;
+    if(n == 0 || n > Problem::max_n || width == 0 || width > Problem::max_n)
+    {
+        error = path + ": the board must have 1 to " + std::to_string(Problem::max_n) + " rows and columns";
+        return false;
+    }
+    if(variant == toroidal_variant && width != n)
+    {
+        error = path + ": a toroidal board must be square";
+        return false;
+    }
+
+    problem = Problem(n, width, std::min(n, width), variant);
+    std::vector<std::pair<unsigned int, unsigned int> > queens;
+    for(unsigned int row = 0; row < n; ++row)
+    {
+        if(rows[row].size() != width)
+        {
+            error = path + ": row " + std::to_string(row) + " has " + std::to_string(rows[row].size())
+                    + " cells, the board is " + std::to_string(n) + "x" + std::to_string(width);
+            return false;
+        }
+        unsigned int queens_in_row = 0;
+        for(unsigned int column = 0; column < width; ++column)
+        {
+            char cell = rows[row][column];
+            if(cell == 'x' || cell == 'X') problem.allowed[row] &= ~(1ULL << column);
+            else if(cell == 'Q' || cell == 'q')
+            {
+                queens.push_back(std::make_pair(row, column));
+                ++queens_in_row;
+            }
+            else if(cell != '.')
+            {
+                error = path + ": unknown cell '" + std::string(1, cell) + "' in row " + std::to_string(row);
+                return false;
+            }
+        }
+        if(queens_in_row > 1)
+        {
+            error = path + ": row " + std::to_string(row) + " has more than one queen";
+            return false;
+        }
+    }
+
+    //a pre-placed queen fixes its row and removes the cells it attacks from all other rows.  Two queens that
+    //attack each other remove each other's cell, which leaves a row without allowed columns and no solutions
+    for(size_t i = 0; i < queens.size(); ++i)
+    {
+        unsigned int queen_row = queens[i].first, queen_column = queens[i].second;
+        problem.allowed[queen_row] &= 1ULL << queen_column;
+        problem.queen_rows |= 1ULL << queen_row;
+        for(unsigned int row = 0; row < n; ++row)
+        {
+            for(unsigned int column = 0; row != queen_row && column < width; ++column)
+                if(attacks(problem, queen_row, queen_column, row, column)) problem.allowed[row] &= ~(1ULL << column);
+        }
+    }
+    return true;
+}
+
+void problem_by_level(const Problem& problem, std::vector<unsigned int> pos, unsigned int start_level,
+                      unsigned int max_level, void (* const success_func)(std::vector<unsigned int>&))
+{
+    //like nqueens_by_level, pass partial solutions of exactly max_level entries
+    std::vector<unsigned int> solution(max_level);
+    SolutionIterator it(problem, pos.data(), start_level, max_level);
+    while(it.next())
+    {
+        std::copy(it.solution(), it.solution() + max_level, solution.begin());
+        success_func(solution);
+    }
+}
+
+std::vector<unsigned int> solve_problem(const Problem& problem)
+{
+    std::vector<unsigned int> solutions;
+    SolutionIterator it(problem, NULL, 0, problem.n);
+    while(it.next()) solutions.insert(solutions.end(), it.solution(), it.solution() + problem.n);
+    return solutions;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file    problem.h
+ * @brief   Declares the general problem description solved by the bit mask
+ *          engine (see solution_iterator.h): a board of any width whose
+ *          cells may be blocked or already hold a queen, compiled into one
+ *          mask of allowed columns per row, on which a given number of
+ *          queens is placed.
+ *
+ * The plain n-queens problem keeps using nqueens_by_level(); a Problem is
+ * only needed for everything that does not fit its row prefix model.  The
+ * masters pass the problem to the workers (see master_worker.h), so every
+ * solver runs on it with the same prefix decomposition.
+ */
+
+#ifndef PROBLEM_H
+#define PROBLEM_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+//the attack rules.  The numeric values are sent to the workers, so never reorder them
+enum Problem_Variant
+{
+    queens_variant = 0,         //the standard rules: rows, columns and diagonals
+    toroidal_variant = 1,       //the board is a torus: the diagonals wrap around its edges
+    superqueen_variant = 2      //a queen also attacks like a knight
+};
+
+/**
+ * @brief Parses a variant name (queens, toroidal, superqueen).
+ */
+bool parse_variant(const std::string& name, Problem_Variant& variant);
+
+/**
+ * @brief A board of n rows and `width` columns on which `queens` rows get
+ *        one queen each, in one of their allowed columns, and the other rows
+ *        stay empty.
+ *
+ * A solution has one entry per row: the column of its queen, or `width` for
+ * an empty row.  Empty rows sort after every column, so the lexicographic
+ * order of the solutions is the order in which they are found.
+ */
+struct Problem
+{
+    //boards up to this many rows and columns are supported (a row is a 64 bit mask)
+    static const unsigned int max_n = 64;
+
+    unsigned int variant;
+    unsigned int n;
+    unsigned int width;
+    unsigned int queens;        //at most min(n, width)
+    uint64_t queen_rows;        //the rows that cannot stay empty: those of the pre-placed queens
+    //per row: the columns a queen may be placed in.  Cells attacked by a pre-placed queen are excluded,
+    //and the row of a pre-placed queen allows only its column
+    std::vector<uint64_t> allowed;
+
+    /**
+     * @brief The n-queens problem of the given variant: every cell allowed.
+     */
+    explicit Problem(unsigned int board_size = 0, Problem_Variant board_variant = queens_variant);
+
+    /**
+     * @brief The placements of `num_queens` queens on a board of `rows` x `columns` cells, every cell allowed.
+     */
+    Problem(unsigned int rows, unsigned int columns, unsigned int num_queens, Problem_Variant board_variant);
+
+    //the mask with all columns set
+    uint64_t all_columns() const { return width >= 64 ? ~0ULL : (1ULL << width) - 1; }
+
+    //whether the board is not n x n or some rows stay empty; such solutions have empty row entries
+    bool rectangular() const { return width != n || queens != n; }
+
+    //whether the solutions are closed under the 8 symmetries of the square: an n x n board of n queens
+    //without blocked cells or pre-placed queens, of any variant
+    bool symmetric() const;
+
+    /**
+     * @brief Appends the problem to `words`, to be sent to the workers.
+     */
+    void serialize(std::vector<unsigned int>& words) const;
+
+    /**
+     * @brief Reads a problem written by serialize().  Returns false if the words do not describe one.
+     */
+    bool deserialize(const unsigned int* words, size_t size);
+};
+
+/**
+ * @brief Returns whether a queen on (row, column) attacks the cell (to_row, to_column) under the rules of the variant.
+ */
+bool attacks(const Problem& problem, unsigned int row, unsigned int column, unsigned int to_row, unsigned int to_column);
+
+/**
+ * @brief Reads a completion problem: one line per row and one character per
+ *        cell, `.` for a free cell, `Q` for a pre-placed queen and `x` for a
+ *        blocked cell.  Empty lines and lines starting with `#` are ignored.
+ *
+ * All rows have the same number of cells, which need not be the number of
+ * rows; min(rows, columns) queens are placed.  The pre-placed queens are
+ * compiled into the allowed masks of all rows, under the attack rules of
+ * the given variant.
+ *
+ * @param error Receives a description of the problem with the file if it cannot be used.
+ */
+bool read_problem_file(const std::string& path, Problem_Variant variant, Problem& problem, std::string& error);
+
+/**
+ * @brief The nqueens_by_level() of a problem: calls `success_func` for every
+ *        valid partial solution of the levels [0, max_level) that extends the
+ *        partial solution in pos[0, start_level), in lexicographic order.  The
+ *        partial solutions are passed as vectors of max_level entries.
+ */
+void problem_by_level(const Problem& problem, std::vector<unsigned int> pos, unsigned int start_level,
+                      unsigned int max_level, void (* const success_func)(std::vector<unsigned int>&));
+
+/**
+ * @brief The nqueens() of a problem: returns all solutions, concatenated.
+ */
+std::vector<unsigned int> solve_problem(const Problem& problem);
+
+#endif // PROBLEM_H
@@ -0,0 +1,261 @@
+/**
+ * @file    reducer.cpp
+ * @brief   Implements the streaming reducers.
+ */
+
+#include "reducer.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "nqueens.h"
+#include "solution_iterator.h"
+
+/**
+ * @brief Appends a 64 bit value as two unsigned ints, low half first.
+ */
+void serialize_u64(std::vector<unsigned int>& state, uint64_t value)
+{
+    state.push_back(static_cast<unsigned int>(value));
+    state.push_back(static_cast<unsigned int>(value >> 32));
+}
+
+/**
+ * @brief Reads a 64 bit value written by serialize_u64().
+ */
+uint64_t deserialize_u64(const unsigned int* state)
+{
+    return (static_cast<uint64_t>(state[1]) << 32) | state[0];
+}
+
+void Reducer::accumulate_all(const unsigned int* solutions, size_t size)
+{
+    for(size_t i = 0; i + board_size <= size; i += board_size) accumulate(solutions + i);
+}
+
+//counts the solutions
+class CountReducer : public Reducer
+{
+public:
+    Reducer_Type type() const { return count_reducer; }
+    void init(unsigned int n) { board_size = n; count = 0; }
+    void accumulate(const unsigned int*) { ++count; }
+    void merge(const unsigned int* state, size_t) { count += deserialize_u64(state); }
+    void serialize(std::vector<unsigned int>& state) const { serialize_u64(state, count); }
+    void print(std::ostream& out) const { out << "count " << count << std::endl; }
+
+private:
+    uint64_t count;
+};
+
+//counts, for every row, the solutions with their queen in each column
+class HistogramReducer : public Reducer
+{
+public:
+    Reducer_Type type() const { return histogram_reducer; }
+    void init(unsigned int n) { board_size = n; counts.assign(n * n, 0); }
+    void accumulate(const unsigned int* solution)
+    {
+        for(unsigned int row = 0; row < board_size; ++row) ++counts[row * board_size + solution[row]];
+    }
+    void merge(const unsigned int* state, size_t)
+    {
+        for(size_t i = 0; i < counts.size(); ++i) counts[i] += deserialize_u64(state + 2 * i);
+    }
+    void serialize(std::vector<unsigned int>& state) const
+    {
+        for(size_t i = 0; i < counts.size(); ++i) serialize_u64(state, counts[i]);
+    }
+    void print(std::ostream& out) const
+    {
+        out << "histogram (rows: row, columns: column of the queen)" << std::endl;
+        for(unsigned int row = 0; row < board_size; ++row)
+        {
+            for(unsigned int col = 0; col < board_size; ++col) out << (col != 0 ? "\t" : "") << counts[row * board_size + col];
+            out << std::endl;
+        }
+    }
+
+private:
+    std::vector<uint64_t> counts;
+};
+
+/**
+ * @brief Hashes one solution (splitmix64 finalizer over its entries).
+ */
+uint64_t hash_solution(const unsigned int* solution, unsigned int n)
+{
+    uint64_t hash = n;
+    for(unsigned int i = 0; i < n; ++i)
+    {
+        hash += 0x9e3779b97f4a7c15ULL + solution[i];
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+        hash ^= hash >> 31;
+    }
+    return hash;
+}
+
+//sums the hashes of all solutions, which does not depend on their order
+class FingerprintReducer : public Reducer
+{
+public:
+    Reducer_Type type() const { return fingerprint_reducer; }
+    void init(unsigned int n) { board_size = n; sum = 0; count = 0; }
+    void accumulate(const unsigned int* solution) { sum += hash_solution(solution, board_size); ++count; }
+    void merge(const unsigned int* state, size_t) { sum += deserialize_u64(state); count += deserialize_u64(state + 2); }
+    void serialize(std::vector<unsigned int>& state) const { serialize_u64(state, sum); serialize_u64(state, count); }
+    void print(std::ostream& out) const
+    {
+        char hex[17];
+        snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(sum));
+        out << "fingerprint " << hex << " of " << count << " solutions" << std::endl;
+    }
+
+private:
+    uint64_t sum, count;
+};
+
+//keeps the lexicographically smallest (or largest) solution
+class ExtremeReducer : public Reducer
+{
+public:
+    explicit ExtremeReducer(bool keep_largest) : largest(keep_largest) {}
+    Reducer_Type type() const { return largest ? lexmax_reducer : lexmin_reducer; }
+    void init(unsigned int n) { board_size = n; found = false; best.assign(n, 0); }
+    void accumulate(const unsigned int* solution)
+    {
+        bool better = largest ? std::lexicographical_compare(best.begin(), best.end(), solution, solution + board_size)
+                              : std::lexicographical_compare(solution, solution + board_size, best.begin(), best.end());
+        if(!found || better) std::copy(solution, solution + board_size, best.begin());
+        found = true;
+    }
+    //the state is a found flag followed by the solution
+    void merge(const unsigned int* state, size_t) { if(state[0] != 0) accumulate(state + 1); }
+    void serialize(std::vector<unsigned int>& state) const
+    {
+        state.push_back(found ? 1 : 0);
+        state.insert(state.end(), best.begin(), best.end());
+    }
+    void print(std::ostream& out) const
+    {
+        out << (largest ? "lexmax" : "lexmin");
+        if(!found) out << " none";
+        for(unsigned int i = 0; found && i < board_size; ++i) out << ' ' << best[i];
+        out << std::endl;
+    }
+
+private:
+    bool largest;
+    bool found;
+    std::vector<unsigned int> best;
+};
+
+/**
+ * @brief Returns the number of symmetries of the square that map the solution onto itself (1, 2, 4 or 8).
+ *
+ * A solution is a permutation, so no reflection fixes it for n > 1; only the
+ * rotations by 180 and by 90 degrees can.
+ */
+unsigned int symmetry_group_size(const unsigned int* solution, unsigned int n)
+{
+    if(n == 1) return 8;
+    bool half_turn = true, quarter_turn = true;
+    for(unsigned int row = 0; row < n; ++row)
+    {
+        //the 180 degree rotation maps (row, col) to (n-1-row, n-1-col), the 90 degree rotation to (col, n-1-row)
+        half_turn = half_turn && solution[n - 1 - row] == n - 1 - solution[row];
+        quarter_turn = quarter_turn && solution[solution[row]] == n - 1 - row;
+    }
+    return quarter_turn ? 4 : half_turn ? 2 : 1;
+}
+
+//counts the solutions by the size of their symmetry group
+class SymmetryReducer : public Reducer
+{
+public:
+    Reducer_Type type() const { return symmetry_reducer; }
+    void init(unsigned int n) { board_size = n; std::fill(counts, counts + 4, 0); }
+    void accumulate(const unsigned int* solution)
+    {
+        unsigned int group = symmetry_group_size(solution, board_size);
+        ++counts[group == 8 ? 3 : group / 2];
+    }
+    void merge(const unsigned int* state, size_t)
+    {
+        for(int i = 0; i < 4; ++i) counts[i] += deserialize_u64(state + 2 * i);
+    }
+    void serialize(std::vector<unsigned int>& state) const
+    {
+        for(int i = 0; i < 4; ++i) serialize_u64(state, counts[i]);
+    }
+    void print(std::ostream& out) const
+    {
+        //a class of solutions with a symmetry group of size g has 8/g members
+        uint64_t classes = counts[0] / 8 + counts[1] / 4 + counts[2] / 2 + counts[3];
+        out << "symmetry asymmetric " << counts[0] << " half-turn " << counts[1] << " quarter-turn " << counts[2]
+            << " (" << classes << " distinct classes)" << std::endl;
+    }
+
+private:
+    uint64_t counts[4]; //symmetry group of size 1, 2, 4 and 8 (n = 1 only)
+};
+
+Reducer* create_reducer(Reducer_Type type)
+{
+    switch(type)
+    {
+        case count_reducer: return new CountReducer();
+        case histogram_reducer: return new HistogramReducer();
+        case fingerprint_reducer: return new FingerprintReducer();
+        case lexmin_reducer: return new ExtremeReducer(false);
+        case lexmax_reducer: return new ExtremeReducer(true);
+        case symmetry_reducer: return new SymmetryReducer();
+        default: return NULL;
+    }
+}
+
+bool parse_reducer(const std::string& name, Reducer_Type& type)
+{
+    if(name == "count") type = count_reducer;
+    else if(name == "histogram") type = histogram_reducer;
+    else if(name == "fingerprint") type = fingerprint_reducer;
+    else if(name == "lexmin") type = lexmin_reducer;
+    else if(name == "lexmax") type = lexmax_reducer;
+    else if(name == "symmetry") type = symmetry_reducer;
+    else return false;
+    return true;
+}
+
+//the reducer of the sequential run, used from within its nqueens_by_level callback
+struct SequentialReducer
+{
+    static Reducer*& reducer()
+    {
+        static Reducer* current;
+        return current;
+    }
+};
+
+//accumulates every solution found by the sequential solver
+void reduce_solution_callback(std::vector<unsigned int>& solution)
+{
+    SequentialReducer::reducer()->accumulate(solution.data());
+}
+
+void reduce_sequential(unsigned int n, Reducer& reducer)
+{
+    reducer.init(n);
+    SequentialReducer::reducer() = &reducer;
+    std::vector<unsigned int> zero(n, 0);
+    nqueens_by_level(zero, 0, n, &reduce_solution_callback);
+    SequentialReducer::reducer() = NULL;
+}
+
+void reduce_sequential(const Problem& problem, Reducer& reducer)
+{
+    reducer.init(problem.n);
+    SolutionIterator it(problem, NULL, 0, problem.n);
+    while(it.next()) reducer.accumulate(it.solution());
+}
@@ -0,0 +1,101 @@
+/**
+ * @file    reducer.h
+ * @brief   Declares the streaming reducers, which compute aggregates of the
+ *          solutions (counts, histograms, fingerprints, ...) without keeping
+ *          the solutions themselves.
+ *
+ * A reducer accumulates solutions one at a time where they are found, e.g.
+ * on the workers, and its state is serialized into a few integers, sent to
+ * the master and merged there.  Every reducer is commutative, so the order
+ * in which tasks complete does not matter.
+ */
+
+#ifndef REDUCER_H
+#define REDUCER_H
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stddef.h>
+
+#include "problem.h"
+
+//the available reducers.  The numeric values are sent to the workers, so never reorder them
+enum Reducer_Type
+{
+    no_reducer = 0,
+    count_reducer = 1,          //number of solutions
+    histogram_reducer = 2,      //for every row, how many solutions have their queen in each column
+    fingerprint_reducer = 3,    //order independent 64 bit hash of the solution set
+    lexmin_reducer = 4,         //lexicographically smallest solution
+    lexmax_reducer = 5,         //lexicographically largest solution
+    symmetry_reducer = 6        //solutions by size of their symmetry group, and the number of distinct classes
+};
+
+/**
+ * @brief The interface of all reducers.
+ */
+class Reducer
+{
+public:
+    virtual ~Reducer() {}
+
+    virtual Reducer_Type type() const = 0;
+
+    /**
+     * @brief Resets the state to that of an empty set of solutions of size n.
+     */
+    virtual void init(unsigned int n) = 0;
+
+    /**
+     * @brief Adds one solution of n() entries.
+     */
+    virtual void accumulate(const unsigned int* solution) = 0;
+
+    /**
+     * @brief Adds the state of another reducer of the same type and n, as written by serialize().
+     */
+    virtual void merge(const unsigned int* state, size_t size) = 0;
+
+    /**
+     * @brief Appends the state to `state`.
+     */
+    virtual void serialize(std::vector<unsigned int>& state) const = 0;
+
+    /**
+     * @brief Prints the result in human readable form.
+     */
+    virtual void print(std::ostream& out) const = 0;
+
+    unsigned int n() const { return board_size; }
+
+    /**
+     * @brief Adds `size / n()` concatenated solutions.
+     */
+    void accumulate_all(const unsigned int* solutions, size_t size);
+
+protected:
+    unsigned int board_size;
+};
+
+/**
+ * @brief Creates a reducer of the given type, or returns NULL for no_reducer.
+ */
+Reducer* create_reducer(Reducer_Type type);
+
+/**
+ * @brief Parses a reducer name (count, histogram, fingerprint, lexmin, lexmax, symmetry).
+ */
+bool parse_reducer(const std::string& name, Reducer_Type& type);
+
+/**
+ * @brief Reduces all solutions of the n-queens problem sequentially, without storing any.
+ */
+void reduce_sequential(unsigned int n, Reducer& reducer);
+
+/**
+ * @brief Reduces all solutions of a general problem sequentially, without storing any.
+ */
+void reduce_sequential(const Problem& problem, Reducer& reducer);
+
+#endif // REDUCER_H
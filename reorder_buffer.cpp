@@ -0,0 +1,35 @@
+/**
+ * @file    reorder_buffer.cpp
+ * @brief   Implements the reorder buffer.
+ */
+
+#include "reorder_buffer.h"
+
+ReorderBuffer::ReorderBuffer(SolutionSink& out, size_t window)
+    : output(out), slots(window > 0 ? window : 1), done(slots.size(), false), next(0)
+{
+}
+
+void ReorderBuffer::append(unsigned int task_id, const unsigned int* begin, const unsigned int* end)
+{
+    if(task_id == next) output.add_solutions(begin, end);
+    else
+    {
+        std::vector<unsigned int>& slot = slots[task_id % slots.size()];
+        slot.insert(slot.end(), begin, end);
+    }
+}
+
+void ReorderBuffer::complete(unsigned int task_id)
+{
+    done[task_id % slots.size()] = true;
+    while(done[next % slots.size()])
+    {
+        done[next % slots.size()] = false;
+        ++next;
+        //the new oldest task may already have solutions waiting, they go first.  Its later solutions go to the output directly
+        std::vector<unsigned int>& slot = slots[next % slots.size()];
+        if(!slot.empty()) output.add_solutions(slot.data(), slot.data() + slot.size());
+        std::vector<unsigned int>().swap(slot);
+    }
+}
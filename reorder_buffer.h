@@ -0,0 +1,58 @@
+/**
+ * @file    reorder_buffer.h
+ * @brief   Declares the reorder buffer that puts the results of tasks, which
+ *          complete in any order, back into task order.
+ *
+ * Tasks are numbered in the lexicographic order of their prefixes, so
+ * emitting their solutions in task order reproduces the order of the
+ * sequential nqueens() without sorting.
+ */
+
+#ifndef REORDER_BUFFER_H
+#define REORDER_BUFFER_H
+
+#include <vector>
+#include <stddef.h>
+
+#include "solution_sink.h"
+
+//default number of tasks that may be outstanding beyond the oldest unfinished one
+const size_t default_reorder_window = 4096;
+
+/**
+ * @brief Passes the solutions of tasks to an output sink in task order.
+ *
+ * The solutions of the oldest unfinished task go to the output directly, those
+ * of later tasks are held until all earlier tasks are complete.  Only tasks in
+ * [next_task(), next_task() + window) may be given to the buffer, so at most
+ * `window` tasks are held at any time; callers stop dispatching tasks for
+ * which has_room() is false until earlier tasks complete.
+ */
+class ReorderBuffer
+{
+public:
+    ReorderBuffer(SolutionSink& output, size_t window);
+
+    //whether the given task may be dispatched now
+    bool has_room(unsigned int task_id) const { return task_id < next + slots.size(); }
+    //the oldest task that has not completed yet
+    unsigned int next_task() const { return next; }
+
+    /**
+     * @brief Adds solutions of a task.  A task may add its solutions in several parts.
+     */
+    void append(unsigned int task_id, const unsigned int* begin, const unsigned int* end);
+
+    /**
+     * @brief Marks the task as complete, no more solutions will be added for it.
+     */
+    void complete(unsigned int task_id);
+
+private:
+    SolutionSink& output;
+    std::vector<std::vector<unsigned int> > slots; //slot task_id % window holds the solutions of a waiting task
+    std::vector<bool> done;
+    unsigned int next;
+};
+
+#endif // REORDER_BUFFER_H
@@ -0,0 +1,83 @@
+/**
+ * @file    server_main.cpp
+ * @brief   Implements the main routine of the local n-queens query server.
+ */
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <string>
+
+#include "nqueens_threads.h"
+#include "nqueens_server.h"
+
+
+/**
+ * Prints the usage of the program.
+ */
+void print_usage() {
+    std::cerr << "Usage: ./nqueens-server [options] <socket>" << std::endl;
+    std::cerr << "      Required arguments:" << std::endl;
+    std::cerr << "          <socket>    Path of the Unix domain socket to listen on." << std::endl;
+    std::cerr << "      Optional arguments:" << std::endl;
+    std::cerr << "          -j <p>      Number of solver threads (default: number of cores)." << std::endl;
+    std::cerr << "          -k <k>      Number of levels solved before splitting a query into" << std::endl;
+    std::cerr << "                      tasks for the solver threads (default: 3)." << std::endl;
+    std::cerr << "          -c <dir>    Persistent result cache shared with ./nqueens -c." << std::endl;
+    std::cerr << "          -m <MB>     Memory for cached solutions; the least recently used" << std::endl;
+    std::cerr << "                      results are dropped beyond it (default: " << server_default_cache_mb << ")." << std::endl;
+    std::cerr << "      Protocol:" << std::endl;
+    std::cerr << "          One request per line: `count <n>`, `first <n>` or `all <n>`, or" << std::endl;
+    std::cerr << "          `page <n> <first> <m>` for the solutions of rank first .. first + m - 1." << std::endl;
+    std::cerr << "          Reply: `ok <count> <lines>` followed by <lines> solutions, or" << std::endl;
+    std::cerr << "          `error <message>`." << std::endl;
+    std::cerr << "      Example:" << std::endl;
+    std::cerr << "          ./nqueens-server -j 8 /tmp/nqueens.sock" << std::endl;
+    std::cerr << "          echo 'count 12' | nc -U /tmp/nqueens.sock" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int num_threads = default_num_threads();
+    int k = 3;
+    std::string cache_dir;
+    long cache_mb = server_default_cache_mb;
+
+    // forget about first argument (which is the executable's name)
+    argc--;
+    argv++;
+
+    // parse optional parameters
+    while (argc > 1 && argv[0][0] == '-') {
+        char option = argv[0][1];
+        switch (option) {
+            case 'j':
+                num_threads = atoi(argv[1]);
+                break;
+            case 'k':
+                k = atoi(argv[1]);
+                break;
+            case 'c':
+                cache_dir = argv[1];
+                break;
+            case 'm':
+                cache_mb = atol(argv[1]);
+                break;
+            default:
+                print_usage();
+                exit(EXIT_FAILURE);
+        }
+        // all options take a value
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc != 1 || argv[0][0] == '-' || num_threads == 0 || k <= 0 || cache_mb < 0) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    // the solver threads inherit the blocked stop signals, which only the accepting thread waits for
+    block_stop_signals();
+    SolverPool pool(num_threads);
+    return run_server(argv[0], pool, k, cache_dir, static_cast<size_t>(cache_mb) << 20);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file    server_test.cpp
+ * @brief   Tests the query server with concurrent requests: starts
+ *          ./nqueens-server, sends one `page` request per board size from
+ *          threads of its own at the same time, so that the solution indexes
+ *          of all sizes are built concurrently, and checks every reply
+ *          against the solution iterator.
+ */
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <thread>
+#include <chrono>
+
+#include "solution_iterator.h"
+
+//the board sizes requested at the same time, and the solutions per page
+const unsigned int first_n = 4;
+const unsigned int last_n = 13;
+const unsigned int page_size = 3;
+
+/**
+ * @brief Connects to the server, retrying while it starts up.  Returns -1 on failure.
+ */
+int connect_server(const std::string& socket_path)
+{
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    for(int attempt = 0; attempt < 100; ++attempt)
+    {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if(fd < 0) return -1;
+        if(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) return fd;
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    return -1;
+}
+
+/**
+ * @brief Sends `request` and returns the reply: the status line and the lines it announces.
+ */
+std::string query(const std::string& socket_path, const std::string& request)
+{
+    int fd = connect_server(socket_path);
+    if(fd < 0) return "";
+    std::string line = request + "\n";
+    if(write(fd, line.data(), line.size()) != (ssize_t) line.size())
+    {
+        close(fd);
+        return "";
+    }
+
+    //the reply is complete once the announced number of lines has arrived
+    std::string reply;
+    char chunk[4096];
+    while(true)
+    {
+        size_t header_end = reply.find('\n');
+        if(header_end != std::string::npos)
+        {
+            std::istringstream header(reply.substr(0, header_end));
+            std::string status;
+            unsigned long long count = 0, lines = 0;
+            header >> status >> count >> lines;
+            size_t newlines = 0;
+            for(size_t i = 0; i < reply.size(); ++i) newlines += reply[i] == '\n';
+            if(status != "ok" || newlines >= lines + 1) break;
+        }
+        ssize_t ret = read(fd, chunk, sizeof(chunk));
+        if(ret <= 0) break;
+        reply.append(chunk, ret);
+    }
+    close(fd);
+    return reply;
+}
+
+/**
+ * @brief Returns the reply the server has to give to `page n 0 page_size`.
+ */
+std::string expected_page(unsigned int n)
+{
+    std::vector<std::string> lines;
+    unsigned long long count = 0;
+    SolutionIterator it(n);
+    while(it.next())
+    {
+        if(count++ >= page_size) continue;
+        std::ostringstream line;
+        for(unsigned int i = 0; i < n; ++i) line << (i > 0 ? " " : "") << it.solution()[i];
+        lines.push_back(line.str());
+    }
+    std::ostringstream reply;
+    reply << "ok " << count << " " << lines.size() << "\n";
+    for(size_t i = 0; i < lines.size(); ++i) reply << lines[i] << "\n";
+    return reply.str();
+}
+
+int main() {
+    std::string socket_path = "/tmp/nqueens-server-test." + std::to_string(getpid()) + ".sock";
+    pid_t server = fork();
+    if (server == 0) {
+        execl("./nqueens-server", "./nqueens-server", "-j", "4", socket_path.c_str(), (char*) NULL);
+        perror("./nqueens-server");
+        _exit(127);
+    }
+    if (server < 0) {
+        perror("fork");
+        return EXIT_FAILURE;
+    }
+
+    // every size on its own connection and thread, all at once
+    std::vector<std::string> replies(last_n - first_n + 1);
+    std::vector<std::thread> clients;
+    for (unsigned int n = first_n; n <= last_n; ++n) {
+        std::string request = "page " + std::to_string(n) + " 0 " + std::to_string(page_size);
+        clients.push_back(std::thread([&replies, &socket_path, request, n]() {
+            replies[n - first_n] = query(socket_path, request);
+        }));
+    }
+    for (size_t i = 0; i < clients.size(); ++i)
+        clients[i].join();
+
+    int failures = 0;
+    for (unsigned int n = first_n; n <= last_n; ++n) {
+        std::string expected = expected_page(n);
+        if (replies[n - first_n] != expected) {
+            std::cerr << "[ERROR]: page " << n << " 0 " << page_size << ": expected" << std::endl << expected
+                      << "got" << std::endl << replies[n - first_n] << std::endl;
+            ++failures;
+        }
+    }
+
+    // the server has to survive the requests and shut down cleanly
+    int status = 0;
+    if (waitpid(server, &status, WNOHANG) != 0) {
+        std::cerr << "[ERROR]: the server exited during the requests (status " << status << ")" << std::endl;
+        return EXIT_FAILURE;
+    }
+    kill(server, SIGTERM);
+    waitpid(server, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "[ERROR]: the server did not shut down cleanly (status " << status << ")" << std::endl;
+        ++failures;
+    }
+
+    if (failures > 0)
+        return EXIT_FAILURE;
+    std::cout << "server test passed: " << replies.size() << " concurrent page requests" << std::endl;
+    return EXIT_SUCCESS;
+}
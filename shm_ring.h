@@ -0,0 +1,124 @@
+/**
+ * @file    shm_ring.h
+ * @brief   Implements a single-producer single-consumer byte ring buffer that
+ *          can live in memory shared between processes.
+ */
+
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <atomic>
+#include <thread>
+#include <new>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief A byte ring buffer for one writer and one reader.
+ *
+ * The ring is placed into shared memory with ShmRing::create().  `head` and
+ * `tail` count all bytes ever read and written, so the fill level is their
+ * difference.  Both live on their own cache line to avoid false sharing.
+ * Writes and reads larger than the ring are streamed through it piecewise.
+ */
+struct ShmRing
+{
+    std::atomic<uint64_t> head; //bytes read so far, written by the reader
+    char head_padding[64 - sizeof(std::atomic<uint64_t>)];
+    std::atomic<uint64_t> tail; //bytes written so far, written by the writer
+    char tail_padding[64 - sizeof(std::atomic<uint64_t>)];
+    uint64_t capacity;
+    char padding[64 - sizeof(uint64_t)];
+
+    unsigned char* buffer() { return reinterpret_cast<unsigned char*>(this + 1); }
+    const unsigned char* buffer() const { return reinterpret_cast<const unsigned char*>(this + 1); }
+
+    //the number of bytes a ring with the given capacity occupies in memory
+    static size_t footprint(uint64_t capacity) { return sizeof(ShmRing) + ((capacity + 63) / 64) * 64; }
+
+    //constructs an empty ring at `memory`, which must be footprint(capacity) bytes
+    static ShmRing* create(void* memory, uint64_t capacity)
+    {
+        ShmRing* ring = static_cast<ShmRing*>(memory);
+        new (&ring->head) std::atomic<uint64_t>(0);
+        new (&ring->tail) std::atomic<uint64_t>(0);
+        ring->capacity = capacity;
+        return ring;
+    }
+
+    //bytes available for reading
+    uint64_t readable() const
+    {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+    }
+
+    //writes `size` bytes, blocking while the ring is full
+    void write(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        while(size > 0)
+        {
+            uint64_t space = capacity - (position - head.load(std::memory_order_acquire));
+            if(space == 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            size_t chunk = copy_chunk(position, size < space ? size : space);
+            memcpy(buffer() + position % capacity, bytes, chunk);
+            bytes += chunk;
+            size -= chunk;
+            position += chunk;
+            tail.store(position, std::memory_order_release);
+        }
+    }
+
+    //reads `size` bytes, blocking until they have been written
+    void read(void* data, size_t size)
+    {
+        unsigned char* bytes = static_cast<unsigned char*>(data);
+        uint64_t position = head.load(std::memory_order_relaxed);
+        while(size > 0)
+        {
+            uint64_t available = tail.load(std::memory_order_acquire) - position;
+            if(available == 0)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            size_t chunk = copy_chunk(position, size < available ? size : available);
+            memcpy(bytes, buffer() + position % capacity, chunk);
+            bytes += chunk;
+            size -= chunk;
+            position += chunk;
+            head.store(position, std::memory_order_release);
+        }
+    }
+
+    //the readable bytes that are contiguous in the buffer, from the read position up to the end of the
+    //buffer at most, to be read in place.  They stay in the ring until consume() is called
+    const unsigned char* readable_span(size_t& size) const
+    {
+        uint64_t position = head.load(std::memory_order_relaxed);
+        uint64_t available = tail.load(std::memory_order_acquire) - position;
+        size = copy_chunk(position, available);
+        return buffer() + position % capacity;
+    }
+
+    //releases `size` readable bytes, read in place, to the writer
+    void consume(size_t size)
+    {
+        head.store(head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+
+private:
+    //limits a copy starting at `position` to the end of the buffer
+    size_t copy_chunk(uint64_t position, size_t size) const
+    {
+        uint64_t to_end = capacity - position % capacity;
+        return size < to_end ? size : to_end;
+    }
+};
+
+#endif // SHM_RING_H
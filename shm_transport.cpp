@@ -0,0 +1,86 @@
+/**
+ * @file    shm_transport.cpp
+ * @brief   Implements the shared memory transport.
+ */
+
+#include "shm_transport.h"
+
+#include <sys/mman.h>
+
+//precedes every message in a ring
+struct ShmMessageHeader
+{
+    int32_t tag;
+    uint32_t reserved;
+    uint64_t count;
+};
+
+ShmTransportGroup::ShmTransportGroup(int size, size_t ring_capacity)
+    : group_size(size), ring_footprint(ShmRing::footprint(ring_capacity))
+{
+    //anonymous shared memory is inherited by forked children; pages are only touched once used
+    memory_size = ring_footprint * size * size;
+    memory = mmap(NULL, memory_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+    {
+        memory = NULL;
+        return;
+    }
+    for(int i = 0; i < size * size; ++i) ShmRing::create(static_cast<char*>(memory) + i * ring_footprint, ring_capacity);
+}
+
+ShmTransportGroup::~ShmTransportGroup()
+{
+    if(memory != NULL) munmap(memory, memory_size);
+}
+
+ShmRing& ShmTransportGroup::ring(int source, int dest)
+{
+    return *reinterpret_cast<ShmRing*>(static_cast<char*>(memory) + (source * group_size + dest) * ring_footprint);
+}
+
+ShmTransport::ShmTransport(ShmTransportGroup& group, int rank) : group(group), my_rank(rank), next_source(0) {}
+
+void ShmTransport::send(int dest, int tag, const unsigned int* data, size_t count)
+{
+    ShmMessageHeader header;
+    header.tag = tag;
+    header.reserved = 0;
+    header.count = count;
+    ShmRing& ring = group.ring(my_rank, dest);
+    ring.write(&header, sizeof(header));
+    ring.write(data, count * sizeof(unsigned int));
+}
+
+void ShmTransport::recv(int source, Message& message)
+{
+    //wait until some ring holds a complete header; the data may still be streaming in
+    ShmRing* ring = NULL;
+    while(ring == NULL)
+    {
+        if(source != any_source)
+        {
+            if(group.ring(source, my_rank).readable() >= sizeof(ShmMessageHeader)) ring = &group.ring(source, my_rank);
+            else std::this_thread::yield();
+            continue;
+        }
+        for(int i = 0; i < group.size() && ring == NULL; ++i)
+        {
+            int candidate = (next_source + i) % group.size();
+            if(group.ring(candidate, my_rank).readable() >= sizeof(ShmMessageHeader))
+            {
+                ring = &group.ring(candidate, my_rank);
+                source = candidate;
+                next_source = (candidate + 1) % group.size();
+            }
+        }
+        if(ring == NULL) std::this_thread::yield();
+    }
+
+    ShmMessageHeader header;
+    ring->read(&header, sizeof(header));
+    message.source = source;
+    message.tag = header.tag;
+    message.data.resize(header.count);
+    ring->read(message.data.data(), header.count * sizeof(unsigned int));
+}
@@ -0,0 +1,63 @@
+/**
+ * @file    shm_transport.h
+ * @brief   Declares the shared memory transport for processes on one node.
+ */
+
+#ifndef SHM_TRANSPORT_H
+#define SHM_TRANSPORT_H
+
+#include "transport.h"
+#include "shm_ring.h"
+
+/**
+ * @brief Shared memory holding one ring buffer for every ordered pair of ranks.
+ *
+ * The group must be created before the processes are forked, so that all of
+ * them inherit the shared mapping.
+ */
+class ShmTransportGroup
+{
+public:
+    ShmTransportGroup(int size, size_t ring_capacity);
+    ~ShmTransportGroup();
+
+    //true if the shared memory could be mapped
+    bool valid() const { return memory != NULL; }
+    int size() const { return group_size; }
+    //the ring carrying messages from rank `source` to rank `dest`
+    ShmRing& ring(int source, int dest);
+
+private:
+    ShmTransportGroup(const ShmTransportGroup&);
+    ShmTransportGroup& operator=(const ShmTransportGroup&);
+
+    int group_size;
+    size_t ring_footprint;
+    void* memory;
+    size_t memory_size;
+};
+
+/**
+ * @brief The endpoint of one process in a ShmTransportGroup.
+ *
+ * A message is written into the ring of its (source, dest) pair as a small
+ * header followed by the data; large messages stream through the ring while
+ * the receiver reads them.
+ */
+class ShmTransport : public Transport
+{
+public:
+    ShmTransport(ShmTransportGroup& group, int rank);
+
+    int rank() const { return my_rank; }
+    int size() const { return group.size(); }
+    void send(int dest, int tag, const unsigned int* data, size_t count);
+    void recv(int source, Message& message);
+
+private:
+    ShmTransportGroup& group;
+    int my_rank;
+    int next_source; //where the next any_source receive starts polling, so no sender is starved
+};
+
+#endif // SHM_TRANSPORT_H
@@ -0,0 +1,318 @@
+/**
+ * @file    sim_main.cpp
+ * @brief   Implements the offline scheduler simulator, which replays the task
+ *          costs recorded by `./nqueens -l <file>` under different machine
+ *          parameters and scheduling policies.
+ *
+ * Model: every message costs `latency` until it arrives plus `bytes /
+ * bandwidth` of the master's time to send or receive it; the master handles
+ * one message at a time.  Generating the prefixes on the master is not
+ * modelled.  Task costs are the workers' measured compute times.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <queue>
+#include <random>
+
+#include "task_log.h"
+
+
+//a unit of work as seen by the simulator
+struct SimTask
+{
+    double cost_us;
+    uint64_t num_solutions;
+};
+
+//the machine and scheduling parameters of one simulation
+struct SimParameters
+{
+    unsigned int p;
+    unsigned int batch;
+    double latency_us;
+    double bytes_per_us;    //equal to the bandwidth in MB/s
+    unsigned int n, k;
+};
+
+//the predicted outcome of one simulation
+struct SimResult
+{
+    double makespan_us;
+    double utilisation;
+};
+
+//defines the scheduling policies
+enum Policy
+{
+    fifo_policy = 0,    //master-worker, tasks in lexicographic (generation) order, as nqueens does
+    lpt_policy = 1,     //master-worker, longest task first (needs an oracle for the costs)
+    random_policy = 2,  //master-worker, tasks in random order
+    steal_policy = 3    //no master: contiguous blocks per rank, idle ranks steal half of the fullest queue
+};
+
+const char* policy_names[] = {"fifo", "lpt", "random", "steal"};
+
+
+/**
+ * Prints the usage of the program.
+ */
+void print_usage() {
+    std::cerr << "Usage: ./nqueens-sim [options] <log>" << std::endl;
+    std::cerr << "      Required arguments:" << std::endl;
+    std::cerr << "          <log>       Task log written by ./nqueens -l <log>." << std::endl;
+    std::cerr << "      Optional arguments (lists are comma separated):" << std::endl;
+    std::cerr << "          -p <list>   Numbers of processors (default: p of the log)." << std::endl;
+    std::cerr << "          -k <list>   Master depths, at most k of the log (default: k of the log)." << std::endl;
+    std::cerr << "          -b <list>   Number of prefixes sent per work message (default: 1)." << std::endl;
+    std::cerr << "          -s <list>   Policies: fifo, lpt, random, steal (default: all)." << std::endl;
+    std::cerr << "          -L <us>     Message latency in microseconds (default: 2)." << std::endl;
+    std::cerr << "          -B <MB/s>   Bandwidth in MB/s (default: 5000)." << std::endl;
+    std::cerr << "      Example:" << std::endl;
+    std::cerr << "          ./nqueens -l run.log 16 4" << std::endl;
+    std::cerr << "          ./nqueens-sim -p 16,32,64 -k 3,4 -b 1,8 run.log" << std::endl;
+}
+
+/**
+ * @brief Parses a comma separated list of positive integers.  Returns false on errors.
+ */
+bool parse_list(const std::string& text, std::vector<unsigned int>& values)
+{
+    std::istringstream list(text);
+    std::string item;
+    values.clear();
+    while(std::getline(list, item, ','))
+    {
+        int value = atoi(item.c_str());
+        if(value <= 0) return false;
+        values.push_back(value);
+    }
+    return !values.empty();
+}
+
+/**
+ * @brief Merges the logged tasks into the tasks of a smaller master depth.
+ *
+ * The log is in lexicographic order, so the tasks sharing their first `k`
+ * levels are adjacent.
+ */
+std::vector<SimTask> coarsen_tasks(const TaskLog& log, unsigned int k)
+{
+    std::vector<SimTask> tasks;
+    for(size_t i = 0; i < log.tasks.size(); ++i)
+    {
+        const TaskRecord& record = log.tasks[i];
+        bool same_group = i > 0 && std::equal(record.prefix.begin(), record.prefix.begin() + k, log.tasks[i-1].prefix.begin());
+        if(!same_group)
+        {
+            SimTask task = {0.0, 0};
+            tasks.push_back(task);
+        }
+        tasks.back().cost_us += record.cost_ns * 1e-3;
+        tasks.back().num_solutions += record.num_solutions;
+    }
+    return tasks;
+}
+
+/**
+ * @brief Simulates the master-worker protocol of master_worker.cpp with batches of tasks.
+ */
+SimResult simulate_master_worker(const std::vector<SimTask>& tasks, const SimParameters& params)
+{
+    //min-heap of (time a worker's request arrives at the master, worker, bytes of results in that request)
+    typedef std::pair<double, std::pair<unsigned int, double> > Request;
+    std::priority_queue<Request, std::vector<Request>, std::greater<Request> > requests;
+    for(unsigned int worker = 1; worker < params.p; ++worker)
+        requests.push(Request(params.latency_us, std::make_pair(worker, 4.0)));
+
+    double master_time = 0.0, busy_us = 0.0;
+    size_t next_task = 0;
+    while(!requests.empty())
+    {
+        Request request = requests.top();
+        requests.pop();
+        master_time = std::max(master_time, request.first) + request.second.second / params.bytes_per_us;
+        if(next_task == tasks.size()) continue; //no work left, the worker is done
+
+        //send the next batch
+        size_t end = std::min(tasks.size(), next_task + params.batch);
+        double compute_us = 0.0, result_bytes = 16.0;
+        for(size_t i = next_task; i < end; ++i)
+        {
+            compute_us += tasks[i].cost_us;
+            result_bytes += tasks[i].num_solutions * params.n * sizeof(unsigned int);
+        }
+        master_time += (end - next_task) * (params.k + 1) * sizeof(unsigned int) / params.bytes_per_us;
+        double done = master_time + params.latency_us + compute_us;
+        requests.push(Request(done + params.latency_us, std::make_pair(request.second.first, result_bytes)));
+        busy_us += compute_us;
+        next_task = end;
+    }
+
+    SimResult result;
+    result.makespan_us = master_time;
+    result.utilisation = params.p > 1 && master_time > 0 ? busy_us / ((params.p - 1) * master_time) : 0.0;
+    return result;
+}
+
+/**
+ * @brief Simulates decentralised work stealing on all `p` ranks, with a final gather of the results.
+ */
+SimResult simulate_stealing(const std::vector<SimTask>& tasks, const SimParameters& params)
+{
+    //every rank starts with a contiguous block of tasks, as [begin, end) index ranges
+    std::vector<size_t> begin(params.p), end(params.p);
+    for(unsigned int rank = 0; rank < params.p; ++rank)
+    {
+        begin[rank] = tasks.size() * rank / params.p;
+        end[rank] = tasks.size() * (rank + 1) / params.p;
+    }
+
+    //min-heap of (time a rank becomes idle, rank)
+    typedef std::pair<double, unsigned int> Idle;
+    std::priority_queue<Idle, std::vector<Idle>, std::greater<Idle> > idle;
+    for(unsigned int rank = 0; rank < params.p; ++rank) idle.push(Idle(0.0, rank));
+
+    double makespan = 0.0, busy_us = 0.0, result_bytes = 0.0;
+    while(!idle.empty())
+    {
+        Idle current = idle.top();
+        idle.pop();
+        unsigned int rank = current.second;
+        if(begin[rank] < end[rank])
+        {
+            const SimTask& task = tasks[begin[rank]++];
+            busy_us += task.cost_us;
+            result_bytes += task.num_solutions * params.n * sizeof(unsigned int);
+            idle.push(Idle(current.first + task.cost_us, rank));
+            continue;
+        }
+
+        //steal the back half of the fullest queue, or stop if no queue has more than one task left
+        unsigned int victim = rank;
+        for(unsigned int other = 0; other < params.p; ++other)
+            if(end[other] - begin[other] > end[victim] - begin[victim]) victim = other;
+        size_t remaining = end[victim] - begin[victim];
+        if(remaining < 2)
+        {
+            makespan = std::max(makespan, current.first);
+            continue;
+        }
+        size_t stolen = remaining / 2;
+        begin[rank] = end[victim] - stolen;
+        end[rank] = end[victim];
+        end[victim] -= stolen;
+        double steal_us = 2 * params.latency_us + stolen * params.k * sizeof(unsigned int) / params.bytes_per_us;
+        idle.push(Idle(current.first + steal_us, rank));
+    }
+
+    SimResult result;
+    result.makespan_us = makespan + params.latency_us + result_bytes / params.bytes_per_us;
+    result.utilisation = result.makespan_us > 0 ? busy_us / (params.p * result.makespan_us) : 0.0;
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    std::vector<unsigned int> procs, depths, batches(1, 1), policies;
+    double latency_us = 2.0, bandwidth_mb = 5000.0;
+
+    // forget about first argument (which is the executable's name)
+    argc--;
+    argv++;
+
+    // parse optional parameters, all of them take a value
+    while (argc > 1 && argv[0][0] == '-') {
+        char option = argv[0][1];
+        std::string value = argv[1];
+        bool ok = true;
+        switch (option) {
+            case 'p': ok = parse_list(value, procs); break;
+            case 'k': ok = parse_list(value, depths); break;
+            case 'b': ok = parse_list(value, batches); break;
+            case 'L': latency_us = atof(value.c_str()); ok = latency_us >= 0; break;
+            case 'B': bandwidth_mb = atof(value.c_str()); ok = bandwidth_mb > 0; break;
+            case 's': {
+                std::istringstream list(value);
+                std::string name;
+                while (ok && std::getline(list, name, ',')) {
+                    unsigned int policy = 0;
+                    while (policy <= steal_policy && name != policy_names[policy]) ++policy;
+                    ok = policy <= steal_policy;
+                    policies.push_back(policy);
+                }
+                break;
+            }
+            default: ok = false;
+        }
+        if (!ok) {
+            print_usage();
+            exit(EXIT_FAILURE);
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc != 1) {
+        print_usage();
+        exit(EXIT_FAILURE);
+    }
+
+    TaskLog log;
+    if (!read_task_log(argv[0], log) || log.tasks.empty()) {
+        std::cerr << "[ERROR]: Could not read the task log " << argv[0] << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (procs.empty()) procs.push_back(log.p);
+    if (depths.empty()) depths.push_back(log.k);
+    if (policies.empty())
+        for (unsigned int policy = fifo_policy; policy <= steal_policy; ++policy) policies.push_back(policy);
+
+    // the recorded run, for comparison with the fifo prediction of the same setting
+    double total_us = 0.0, recorded_us = 0.0;
+    for (size_t i = 0; i < log.tasks.size(); ++i) {
+        total_us += log.tasks[i].cost_ns * 1e-3;
+        recorded_us = std::max(recorded_us, log.tasks[i].result_us);
+    }
+    printf("# n=%u k=%u p=%u tasks=%zu total work %.3f ms, recorded makespan %.3f ms\n",
+           log.n, log.k, log.p, log.tasks.size(), total_us * 1e-3, recorded_us * 1e-3);
+    printf("%-8s %4s %6s %6s %8s %14s %8s %8s\n", "policy", "k", "batch", "p", "tasks", "makespan[ms]", "util", "speedup");
+
+    for (size_t d = 0; d < depths.size(); ++d) {
+        if (depths[d] > log.k) {
+            std::cerr << "[WARNING]: Skipping k=" << depths[d] << ", the log only has prefixes of depth " << log.k << std::endl;
+            continue;
+        }
+        std::vector<SimTask> tasks = coarsen_tasks(log, depths[d]);
+        for (size_t s = 0; s < policies.size(); ++s) {
+            std::vector<SimTask> ordered = tasks;
+            if (policies[s] == lpt_policy) {
+                std::stable_sort(ordered.begin(), ordered.end(),
+                                 [](const SimTask& a, const SimTask& b) { return a.cost_us > b.cost_us; });
+            } else if (policies[s] == random_policy) {
+                std::mt19937 generator(1);
+                std::shuffle(ordered.begin(), ordered.end(), generator);
+            }
+            for (size_t b = 0; b < batches.size(); ++b) {
+                // batches do not apply to stealing
+                if (policies[s] == steal_policy && b > 0) break;
+                for (size_t i = 0; i < procs.size(); ++i) {
+                    // master-worker needs at least one worker besides the master
+                    if (policies[s] != steal_policy && procs[i] < 2) continue;
+                    SimParameters params = {procs[i], batches[b], latency_us, bandwidth_mb, log.n, depths[d]};
+                    SimResult result = policies[s] == steal_policy ? simulate_stealing(ordered, params)
+                                                                   : simulate_master_worker(ordered, params);
+                    printf("%-8s %4u %6u %6u %8zu %14.3f %8.3f %8.2f\n", policy_names[policies[s]], depths[d],
+                           policies[s] == steal_policy ? 0 : batches[b], procs[i], ordered.size(),
+                           result.makespan_us * 1e-3, result.utilisation,
+                           result.makespan_us > 0 ? total_us / result.makespan_us : 0.0);
+                }
+            }
+        }
+    }
+    return 0;
+}
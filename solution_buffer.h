@@ -0,0 +1,53 @@
+/**
+ * @file    solution_buffer.h
+ * @brief   Declares the buffer of large flat solution sets that are sized
+ *          first and written afterwards, like the merged result of the pool.
+ *
+ * std::vector's resize() value-initializes, i.e. zero-fills, the new values.
+ * For a result of hundreds of MB that is a full pass over memory before the
+ * values are copied in, and it first touches, and so places, every page on
+ * the NUMA node of the resizing thread.  A SolutionBuffer default-initializes
+ * instead: resize() leaves the new values unwritten, so every page is first
+ * touched by the thread that writes its values.
+ */
+
+#ifndef SOLUTION_BUFFER_H
+#define SOLUTION_BUFFER_H
+
+#include <vector>
+#include <memory>
+#include <new>
+#include <utility>
+
+/**
+ * @brief A std::allocator whose construct() without arguments default-initializes.
+ */
+template <class T>
+class DefaultInitAllocator : public std::allocator<T>
+{
+public:
+    template <class U>
+    struct rebind
+    {
+        typedef DefaultInitAllocator<U> other;
+    };
+
+    DefaultInitAllocator() {}
+    template <class U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) {}
+
+    template <class U>
+    void construct(U* p)
+    {
+        ::new(static_cast<void*>(p)) U;
+    }
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args)
+    {
+        ::new(static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+typedef std::vector<unsigned int, DefaultInitAllocator<unsigned int> > SolutionBuffer;
+
+#endif // SOLUTION_BUFFER_H
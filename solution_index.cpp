@@ -0,0 +1,170 @@
+/**
+ * @file    solution_index.cpp
+ * @brief   Implements the solution index.
+ */
+
+#include "solution_index.h"
+
+#include <unistd.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "nqueens_cache.h"
+#include "nqueens_threads.h"
+#include "solution_iterator.h"
+
+//the header of an index file, followed by the prefixes (one byte per entry) and the offsets
+struct SolutionIndexHeader
+{
+    uint32_t magic;
+    uint32_t version;       //engine version that produced the file
+    uint32_t n;
+    uint32_t depth;
+    uint64_t num_subtrees;
+};
+
+unsigned int default_index_depth(unsigned int n)
+{
+    return std::min(n / 3 + 1, n > 0 ? n - 1 : 0);
+}
+
+SolutionIndex::SolutionIndex() : board_size(0), index_depth(0) {}
+
+void SolutionIndex::build(unsigned int n, unsigned int depth, SolverPool& pool)
+{
+    board_size = n;
+    index_depth = std::min(depth, n > 0 ? n - 1 : 0);
+    prefixes.clear();
+    offsets.assign(1, 0);
+    if(n == 0) return;
+    if(index_depth == 0)
+    {
+        //a single subtree holding every solution (n == 1)
+        SolutionIterator it(n);
+        uint64_t count = 0;
+        while(it.next()) ++count;
+        if(count > 0) offsets.push_back(count);
+        return;
+    }
+
+    //collected here rather than by a nqueens_by_level callback, so that indexes of different n can be built at the same time
+    std::vector<unsigned int> all_prefixes;
+    SolutionIterator it(Problem(n), NULL, 0, index_depth);
+    while(it.next()) all_prefixes.insert(all_prefixes.end(), it.solution(), it.solution() + index_depth);
+
+    SolveResult result = pool.solve_prefixes(n, index_depth, count_mode, all_prefixes);
+
+    //keep the subtrees that hold solutions, so every rank lies in exactly one subtree
+    for(size_t i = 0; i < result.prefix_counts.size(); ++i)
+    {
+        if(result.prefix_counts[i] == 0) continue;
+        for(unsigned int row = 0; row < index_depth; ++row) prefixes.push_back(all_prefixes[i * index_depth + row]);
+        offsets.push_back(offsets.back() + result.prefix_counts[i]);
+    }
+    prefixes.shrink_to_fit();
+    offsets.shrink_to_fit();
+}
+
+bool SolutionIndex::save(const std::string& path) const
+{
+    SolutionIndexHeader header;
+    header.magic = solution_index_magic;
+    header.version = nqueens_engine_version;
+    header.n = board_size;
+    header.depth = index_depth;
+    header.num_subtrees = num_subtrees();
+
+    std::string temp_path = path + ".tmp." + std::to_string(getpid());
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if(file == NULL) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+              && (prefixes.empty() || fwrite(prefixes.data(), 1, prefixes.size(), file) == prefixes.size())
+              && fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file) == offsets.size();
+    ok = (fclose(file) == 0) && ok;
+    if(!ok || rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool SolutionIndex::load(const std::string& path)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if(file == NULL) return false;
+    SolutionIndexHeader header;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == solution_index_magic
+              && header.version == nqueens_engine_version && header.depth < header.n
+              && header.n <= SolutionIterator::max_n;
+    if(ok)
+    {
+        prefixes.resize(header.num_subtrees * header.depth);
+        offsets.resize(header.num_subtrees + 1);
+        ok = (prefixes.empty() || fread(prefixes.data(), 1, prefixes.size(), file) == prefixes.size())
+             && fread(offsets.data(), sizeof(uint64_t), offsets.size(), file) == offsets.size()
+             && fgetc(file) == EOF && offsets[0] == 0;
+    }
+    fclose(file);
+    if(!ok)
+    {
+        board_size = index_depth = 0;
+        prefixes.clear();
+        offsets.clear();
+        return false;
+    }
+    board_size = header.n;
+    index_depth = header.depth;
+    return true;
+}
+
+bool SolutionIndex::unrank(uint64_t rank, unsigned int* solution) const
+{
+    std::vector<unsigned int> found;
+    if(page(rank, 1, found) == 0) return false;
+    std::copy(found.begin(), found.end(), solution);
+    return true;
+}
+
+size_t SolutionIndex::page(uint64_t first, size_t max_count, std::vector<unsigned int>& solutions) const
+{
+    if(first >= count() || max_count == 0) return 0;
+
+    //the last subtree that starts at or before the requested rank
+    size_t subtree = std::upper_bound(offsets.begin(), offsets.end(), first) - offsets.begin() - 1;
+    uint64_t skip = first - offsets[subtree];
+    size_t found = 0;
+    std::vector<unsigned int> prefix(index_depth);
+    for(; subtree < num_subtrees() && found < max_count; ++subtree)
+    {
+        for(unsigned int row = 0; row < index_depth; ++row) prefix[row] = prefixes[subtree * index_depth + row];
+        SolutionIterator it(board_size, prefix.data(), index_depth);
+        //only the first subtree is entered in the middle
+        for(; skip > 0 && it.next(); --skip) {}
+        while(found < max_count && it.next())
+        {
+            solutions.insert(solutions.end(), it.solution(), it.solution() + board_size);
+            ++found;
+        }
+    }
+    return found;
+}
+
+void load_or_build_index(SolutionIndex& index, unsigned int n, SolverPool& pool, const std::string& cache_dir)
+{
+    unsigned int depth = default_index_depth(n);
+    std::string path = cache_dir.empty() ? "" : index_cache_path(cache_dir, n, depth);
+    if(!path.empty() && index.load(path) && index.n() == n) return;
+    index.build(n, depth, pool);
+    if(!path.empty())
+    {
+        create_cache_dir(cache_dir);
+        index.save(path);
+    }
+}
+
+std::string index_cache_path(const std::string& cache_dir, unsigned int n, unsigned int depth)
+{
+    return cache_dir + "/nqueens-v" + std::to_string(nqueens_engine_version) + "-index-" + std::to_string(n) + "-"
+           + std::to_string(depth) + ".bin";
+}
@@ -0,0 +1,104 @@
+/**
+ * @file    solution_index.h
+ * @brief   Declares the solution index, which answers "the i-th solution in
+ *          lexicographic order" and pages of solutions without enumerating
+ *          the solutions before them.
+ *
+ * The index holds every partial solution of the first `depth` rows that has
+ * at least one solution below it, in lexicographic order, together with the
+ * rank of the first solution below it (the number of solutions in all
+ * subtrees before it).  A query binary searches the ranks for the subtree
+ * that holds the requested solution and enumerates only inside that subtree,
+ * skipping every subtree before it as a whole.  The subtree counts are
+ * computed once by the solver pool, in parallel like a count query.
+ */
+
+#ifndef SOLUTION_INDEX_H
+#define SOLUTION_INDEX_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+
+class SolverPool;
+
+//"NQSI" in a little endian file
+const uint32_t solution_index_magic = 0x4953514e;
+
+/**
+ * @brief Returns the index depth used by default: deep enough that every
+ *        subtree is small, shallow enough that the index stays small.
+ */
+unsigned int default_index_depth(unsigned int n);
+
+/**
+ * @brief Random access to the solutions of one board size by their lexicographic rank.
+ *
+ *     SolutionIndex index;
+ *     index.build(n, default_index_depth(n), pool);
+ *     index.page(first, m, solutions); //solutions first, first + 1, ... first + m - 1
+ */
+class SolutionIndex
+{
+public:
+    SolutionIndex();
+
+    /**
+     * @brief Builds the index from the subtree counts of all partial solutions of `depth` rows.
+     *
+     * The depth is reduced to n - 1 if necessary.
+     */
+    void build(unsigned int n, unsigned int depth, SolverPool& pool);
+
+    /**
+     * @brief Writes the index to a file, under a temporary name first like the solution files.
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Reads an index written by save().  Returns false if the file is missing or invalid.
+     */
+    bool load(const std::string& path);
+
+    unsigned int n() const { return board_size; }
+    unsigned int depth() const { return index_depth; }
+    //the number of solutions
+    uint64_t count() const { return offsets.empty() ? 0 : offsets.back(); }
+    //the number of indexed subtrees
+    size_t num_subtrees() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+
+    /**
+     * @brief Writes the solution of the given rank (counting from 0) to `solution`, n() entries.
+     *
+     * @returns false if rank >= count().
+     */
+    bool unrank(uint64_t rank, unsigned int* solution) const;
+
+    /**
+     * @brief Appends the solutions of ranks [first, first + max_count) to `solutions`, as far as they exist.
+     *
+     * @returns the number of solutions appended.
+     */
+    size_t page(uint64_t first, size_t max_count, std::vector<unsigned int>& solutions) const;
+
+private:
+    unsigned int board_size;
+    unsigned int index_depth;
+    std::vector<unsigned char> prefixes; //depth entries per subtree, concatenated
+    std::vector<uint64_t> offsets; //rank of the first solution of every subtree, followed by count()
+};
+
+/**
+ * @brief Returns the path of the index file for (n, depth) in the cache directory.
+ */
+std::string index_cache_path(const std::string& cache_dir, unsigned int n, unsigned int depth);
+
+/**
+ * @brief Loads the index of the default depth for n from the cache directory,
+ *        or builds it and stores it there.  Without a cache directory the
+ *        index is always built.
+ */
+void load_or_build_index(SolutionIndex& index, unsigned int n, SolverPool& pool, const std::string& cache_dir);
+
+#endif // SOLUTION_INDEX_H
@@ -0,0 +1,128 @@
+/**
+ * @file    solution_iterator.cpp
+ * @brief   Implements the explicit-stack solution iterator.
+ */
+
+#include "solution_iterator.h"
+
+#include <stddef.h>
+
+SolutionIterator::SolutionIterator(unsigned int n)
+    : board_size(n), width(n), queens(n), queen_rows(0), toroidal(false), knights(false), depth(n), pos(n), untried(n + 1), columns(n + 1),
+      left_diagonals(n + 1), right_diagonals(n + 1), empty_rows(n + 1), may_skip(0), allowed(n + 1, ~0ULL)
+{
+    start(NULL, 0);
+}
+
+SolutionIterator::SolutionIterator(unsigned int n, const unsigned int* prefix, unsigned int prefix_length)
+    : board_size(n), width(n), queens(n), queen_rows(0), toroidal(false), knights(false), depth(n), pos(n), untried(n + 1), columns(n + 1),
+      left_diagonals(n + 1), right_diagonals(n + 1), empty_rows(n + 1), may_skip(0), allowed(n + 1, ~0ULL)
+{
+    start(prefix, prefix_length);
+}
+
+SolutionIterator::SolutionIterator(const Problem& problem, const unsigned int* prefix, unsigned int prefix_length,
+                                   unsigned int max_depth)
+    : board_size(problem.n), width(problem.width), queens(problem.queens), queen_rows(problem.queen_rows),
+      toroidal(problem.variant == toroidal_variant), knights(problem.variant == superqueen_variant), depth(max_depth), pos(problem.n), untried(problem.n + 1), columns(problem.n + 1),
+      left_diagonals(problem.n + 1), right_diagonals(problem.n + 1), empty_rows(problem.n + 1), may_skip(0),
+      allowed(problem.allowed)
+{
+    allowed.push_back(~0ULL);
+    start(prefix, prefix_length);
+}
+
+void SolutionIterator::start(const unsigned int* prefix, unsigned int prefix_length)
+{
+    all_columns = width >= 64 ? ~0ULL : (1ULL << width) - 1;
+    finished = board_size == 0 || board_size > max_n || width == 0 || width > max_n || depth > board_size
+               || queens > board_size || queens > width;
+    prefix_only = prefix_length == depth;
+    start_level = level = prefix_length;
+
+    //place the queens of the prefix; the diagonals move one column per level, also past empty rows
+    uint64_t cols = 0, left = 0, right = 0;
+    unsigned int empty = 0;
+    for(unsigned int row = 0; row < prefix_length; ++row)
+    {
+        uint64_t queen = prefix[row] < width ? 1ULL << prefix[row] : 0;
+        empty += queen == 0;
+        pos[row] = prefix[row];
+        cols |= queen;
+        left = next_left(left | queen);
+        right = next_right(right | queen);
+    }
+    columns[level] = cols;
+    left_diagonals[level] = left;
+    right_diagonals[level] = right;
+    empty_rows[level] = empty;
+    if(!finished) open_level();
+}
+
+//the choices of the current level: its free allowed columns while queens are left to place, then
+//leaving it empty while enough rows remain for the other queens
+void SolutionIterator::open_level()
+{
+    untried[level] = ~(columns[level] | left_diagonals[level] | right_diagonals[level]) & all_columns & allowed[level];
+    if(knights)
+    {
+        //the knight moves reach two columns from the queen one row up, and one column from the queen two rows up
+        uint64_t attacked = 0;
+        if(level >= 1 && pos[level - 1] < width) attacked |= (1ULL << pos[level - 1] << 2) | (1ULL << pos[level - 1] >> 2);
+        if(level >= 2 && pos[level - 2] < width) attacked |= (1ULL << pos[level - 2] << 1) | (1ULL << pos[level - 2] >> 1);
+        untried[level] &= ~attacked;
+    }
+    if(queens == board_size) return; //every row gets a queen
+    if(level - empty_rows[level] == queens) untried[level] = 0;
+    uint64_t row = level < board_size ? 1ULL << level : 0;
+    if(empty_rows[level] < board_size - queens && !(queen_rows & row)) may_skip |= row;
+    else may_skip &= ~row;
+}
+
+bool SolutionIterator::next()
+{
+    if(finished) return false;
+    if(prefix_only)
+    {
+        //the prefix itself is the only solution
+        finished = true;
+        return true;
+    }
+    while(true)
+    {
+        uint64_t queen;
+        if(untried[level] != 0)
+        {
+            //the lowest untried column comes first, as in nqueens_by_level
+            queen = untried[level] & (~untried[level] + 1);
+            untried[level] &= untried[level] - 1;
+            pos[level] = __builtin_ctzll(queen);
+        }
+        else if((may_skip >> level) & 1)
+        {
+            //an empty row sorts after every column
+            may_skip &= ~(1ULL << level);
+            queen = 0;
+            pos[level] = width;
+        }
+        else
+        {
+            //every choice of this level is done, continue one level up
+            if(level == start_level)
+            {
+                finished = true;
+                return false;
+            }
+            --level;
+            continue;
+        }
+        if(level == depth - 1) return true; //resumes with the next choice of this level
+
+        columns[level + 1] = columns[level] | queen;
+        left_diagonals[level + 1] = next_left(left_diagonals[level] | queen);
+        right_diagonals[level + 1] = next_right(right_diagonals[level] | queen);
+        empty_rows[level + 1] = empty_rows[level] + (queen == 0);
+        ++level;
+        open_level();
+    }
+}
@@ -0,0 +1,104 @@
+/**
+ * @file    solution_iterator.h
+ * @brief   Declares a pull-based iterator over the solutions of the n-queens
+ *          problem, as an alternative to the callbacks of nqueens_by_level().
+ *
+ * The iterator keeps the whole search state (the queens placed so far and
+ * the columns left to try on every level) in explicit arrays, so it can stop
+ * after any solution and resume later.  Nothing beyond the current solution
+ * is ever computed or stored.
+ *
+ * The same iterator is the engine of the general problems of problem.h:
+ * it then only places queens in the allowed columns of each row, follows
+ * the attack rules of the problem's variant, leaves rows empty when fewer
+ * queens than rows are placed, and can stop at a given depth to produce
+ * partial solutions for the workers.
+ */
+
+#ifndef SOLUTION_ITERATOR_H
+#define SOLUTION_ITERATOR_H
+
+#include <vector>
+#include <stdint.h>
+
+#include "problem.h"
+
+/**
+ * @brief Produces the solutions below a partial solution one at a time, in
+ *        the lexicographic order of nqueens_by_level().
+ *
+ *     SolutionIterator it(n);
+ *     for(unsigned int i = 0; i < m && it.next(); ++i) use(it.solution());
+ */
+class SolutionIterator
+{
+public:
+    //boards up to this size are supported (the attacked columns are kept in 64 bit masks)
+    static const unsigned int max_n = 64;
+
+    /**
+     * @brief Iterates over all solutions of the n x n board.
+     */
+    explicit SolutionIterator(unsigned int n);
+
+    /**
+     * @brief Iterates over the solutions that start with the given valid
+     *        partial solution of `prefix_length` queens.
+     */
+    SolutionIterator(unsigned int n, const unsigned int* prefix, unsigned int prefix_length);
+
+    /**
+     * @brief Iterates over the partial solutions of the first `depth` rows of
+     *        the problem that start with the given valid partial solution of
+     *        `prefix_length` <= `depth` queens.  With depth = problem.n, these
+     *        are the solutions.
+     */
+    SolutionIterator(const Problem& problem, const unsigned int* prefix, unsigned int prefix_length, unsigned int depth);
+
+    /**
+     * @brief Advances to the next solution.  Returns false once all solutions have been returned.
+     */
+    bool next();
+
+    //the current solution, n() entries (the first `depth` for partial solutions); valid after next() returned true.
+    //An empty row holds the board width
+    const unsigned int* solution() const { return pos.data(); }
+    unsigned int n() const { return board_size; }
+
+private:
+    void start(const unsigned int* prefix, unsigned int prefix_length);
+    void open_level();
+
+    //the attacked diagonals one row further down: shifted by one column, or rotated on the torus
+    uint64_t next_left(uint64_t diagonals) const
+    {
+        if(toroidal) return ((diagonals << 1) | (diagonals >> (width - 1))) & all_columns;
+        return (diagonals << 1) & all_columns;
+    }
+    uint64_t next_right(uint64_t diagonals) const
+    {
+        if(toroidal) return (diagonals >> 1) | ((diagonals & 1) << (width - 1));
+        return diagonals >> 1;
+    }
+
+    unsigned int board_size; //the number of rows
+    unsigned int width;
+    unsigned int queens; //the rows that get a queen; the others stay empty
+    uint64_t queen_rows; //the rows that cannot stay empty
+    uint64_t all_columns;
+    bool toroidal; //the diagonals wrap around the board edges
+    bool knights; //a queen also attacks like a knight, on the next two rows
+    unsigned int depth; //the length of the returned solutions
+    unsigned int start_level; //levels before it are fixed by the prefix
+    unsigned int level; //the level the search continues on
+    bool finished;
+    bool prefix_only; //the prefix is a complete solution, returned once
+    std::vector<unsigned int> pos;
+    //per level: columns still to try, and the columns and diagonals attacked by the queens above it
+    std::vector<uint64_t> untried, columns, left_diagonals, right_diagonals;
+    std::vector<unsigned int> empty_rows; //per level: the rows left empty above it
+    uint64_t may_skip; //the levels on which leaving the row empty is still to try
+    std::vector<uint64_t> allowed; //per level: the columns a queen may be placed in
+};
+
+#endif // SOLUTION_ITERATOR_H
@@ -0,0 +1,141 @@
+/**
+ * @file    solution_sampler.cpp
+ * @brief   Implements the random sampling of solutions.
+ */
+
+#include "solution_sampler.h"
+
+#include <algorithm>
+
+#include "nqueens_threads.h"
+#include "solution_index.h"
+
+//samples drawn by one pool task
+const size_t samples_per_task = 16;
+
+SampleRandom::SampleRandom(uint64_t seed, uint64_t stream)
+{
+    //decorrelate neighbouring streams by mixing both words before use
+    state = seed ^ (stream * 0xd1342543de82ef95ULL);
+    next();
+}
+
+uint64_t SampleRandom::next()
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+uint64_t SampleRandom::below(uint64_t bound)
+{
+    //multiply-shift with rejection of the values that would favour small results
+    uint64_t threshold = (0 - bound) % bound;
+    while(true)
+    {
+        unsigned __int128 product = static_cast<unsigned __int128>(next()) * bound;
+        if(static_cast<uint64_t>(product) >= threshold) return static_cast<uint64_t>(product >> 64);
+    }
+}
+
+/**
+ * @brief Returns the column of the index-th set bit of the mask.
+ */
+unsigned int select_column(uint64_t mask, unsigned int index)
+{
+    for(; index > 0; --index) mask &= mask - 1;
+    return __builtin_ctzll(mask);
+}
+
+double knuth_probe(BoardMasks board, SampleRandom& random)
+{
+    double estimate = 1.0;
+    while(board.row < board.n)
+    {
+        uint64_t free = board.free();
+        if(free == 0) return 0.0;
+        unsigned int choices = __builtin_popcountll(free);
+        estimate *= choices;
+        board.place(select_column(free, random.below(choices)));
+    }
+    return estimate;
+}
+
+bool sample_uniform(const SolutionIndex& index, size_t m, uint64_t seed, SolverPool& pool, std::vector<unsigned int>& samples)
+{
+    unsigned int n = index.n();
+    if(index.count() == 0) return false;
+    samples.assign(m * n, 0);
+    size_t num_tasks = (m + samples_per_task - 1) / samples_per_task;
+    pool.run_tasks(num_tasks, [&](size_t task) {
+        size_t end = std::min(m, (task + 1) * samples_per_task);
+        for(size_t i = task * samples_per_task; i < end; ++i)
+        {
+            SampleRandom random(seed, i);
+            index.unrank(random.below(index.count()), &samples[i * n]);
+        }
+    });
+    return true;
+}
+
+/**
+ * @brief One weighted random descent.  Returns false if it reached a dead end.
+ */
+bool weighted_descent(unsigned int n, unsigned int probes, SampleRandom& random, unsigned int* solution,
+                      std::vector<double>& weights)
+{
+    BoardMasks board(n);
+    while(board.row < n)
+    {
+        uint64_t free = board.free();
+        if(free == 0) return false;
+        unsigned int choices = __builtin_popcountll(free);
+        unsigned int choice = 0;
+        if(probes == 0 || board.row == n - 1) choice = random.below(choices);
+        else
+        {
+            //weight every free column by the estimated number of solutions below it
+            double total = 0;
+            weights.assign(choices, 0.0);
+            for(unsigned int c = 0; c < choices; ++c)
+            {
+                BoardMasks child = board;
+                child.place(select_column(free, c));
+                for(unsigned int probe = 0; probe < probes; ++probe) weights[c] += knuth_probe(child, random);
+                total += weights[c];
+            }
+            //no probe reached a solution (likely on large boards near the root): no evidence either way
+            if(total == 0) choice = random.below(choices);
+            else
+            {
+                double target = random.uniform() * total;
+                while(choice + 1 < choices && (target -= weights[choice]) >= 0) ++choice;
+                //never pick a column without evidence of a solution below it
+                while(weights[choice] == 0) --choice;
+            }
+        }
+        solution[board.row] = select_column(free, choice);
+        board.place(solution[board.row]);
+    }
+    return true;
+}
+
+bool sample_approximate(unsigned int n, size_t m, uint64_t seed, unsigned int probes, SolverPool& pool,
+                        std::vector<unsigned int>& samples)
+{
+    //every board size has solutions except 2 and 3
+    if(n == 0 || n == 2 || n == 3 || n > max_sample_n) return false;
+    samples.assign(m * n, 0);
+    size_t num_tasks = (m + samples_per_task - 1) / samples_per_task;
+    pool.run_tasks(num_tasks, [&](size_t task) {
+        std::vector<double> weights;
+        size_t end = std::min(m, (task + 1) * samples_per_task);
+        for(size_t i = task * samples_per_task; i < end; ++i)
+        {
+            SampleRandom random(seed, i);
+            while(!weighted_descent(n, probes, random, &samples[i * n], weights)) {}
+        }
+    });
+    return true;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file    solution_sampler.h
+ * @brief   Declares random sampling of solutions: exactly uniform samples
+ *          drawn with a solution index, and approximately uniform samples
+ *          drawn by a weighted random descent for boards too large to count.
+ *
+ * Sample i is drawn from its own random stream derived from (seed, i), so a
+ * run is reproducible from its seed regardless of the number of threads.
+ */
+
+#ifndef SOLUTION_SAMPLER_H
+#define SOLUTION_SAMPLER_H
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+class SolverPool;
+class SolutionIndex;
+
+//boards up to this size can be sampled (the attacked columns are kept in 64 bit masks)
+const unsigned int max_sample_n = 64;
+
+//random probes per candidate column used to weight the approximate descent
+const unsigned int default_sample_probes = 16;
+
+/**
+ * @brief A small, fast random number generator (splitmix64) for one stream of a seed.
+ */
+class SampleRandom
+{
+public:
+    SampleRandom(uint64_t seed, uint64_t stream);
+
+    uint64_t next();
+    //uniform in [0, bound), bound > 0
+    uint64_t below(uint64_t bound);
+    //uniform in [0, 1)
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+private:
+    uint64_t state;
+};
+
+/**
+ * @brief The queens placed in the first `row` rows of an n x n board, as the
+ *        columns and diagonals they attack in the next row.
+ */
+struct BoardMasks
+{
+    unsigned int n;
+    unsigned int row;
+    uint64_t columns, left_diagonals, right_diagonals;
+
+    //an empty board
+    explicit BoardMasks(unsigned int board_size) : n(board_size), row(0), columns(0), left_diagonals(0), right_diagonals(0) {}
+
+    //the columns of the next row that are not attacked
+    uint64_t free() const
+    {
+        uint64_t all_columns = n >= 64 ? ~0ULL : (1ULL << n) - 1;
+        return ~(columns | left_diagonals | right_diagonals) & all_columns;
+    }
+
+    //places a queen in the next row; the diagonals move one column per row
+    void place(unsigned int column)
+    {
+        uint64_t queen = 1ULL << column;
+        uint64_t all_columns = n >= 64 ? ~0ULL : (1ULL << n) - 1;
+        columns |= queen;
+        left_diagonals = ((left_diagonals | queen) << 1) & all_columns;
+        right_diagonals = (right_diagonals | queen) >> 1;
+        ++row;
+    }
+};
+
+/**
+ * @brief One random probe of Knuth's estimator: descends from the board to
+ *        a random leaf, choosing uniformly among the free columns of each row.
+ *
+ * @returns the product of the numbers of free columns on the way if the
+ *          probe reaches a solution, 0 at a dead end.  Its expectation is the
+ *          number of solutions below the board.
+ */
+double knuth_probe(BoardMasks board, SampleRandom& random);
+
+/**
+ * @brief Draws `m` exactly uniform samples with the help of the index: a
+ *        uniform rank, unranked.
+ *
+ * @param samples   Receives m * index.n() values, sample after sample.
+ * @returns false if there is no solution to sample.
+ */
+bool sample_uniform(const SolutionIndex& index, size_t m, uint64_t seed, SolverPool& pool, std::vector<unsigned int>& samples);
+
+/**
+ * @brief Draws `m` approximately uniform samples of the n x n board without counting its solutions.
+ *
+ * Each sample descends row by row, choosing the column of the next queen
+ * with probability proportional to an estimate of the number of solutions
+ * below it (the mean of `probes` Knuth probes), or uniformly where no probe
+ * reached a solution; a descent that reaches a dead end starts over.  With
+ * exact estimates the samples would be uniform; more probes bring them
+ * closer to it.  With 0 probes every free column is equally likely, which is
+ * fast but favours solutions in sparse parts of the tree.
+ *
+ * @returns false if n is larger than max_sample_n or has no solution (2 and 3).
+ */
+bool sample_approximate(unsigned int n, size_t m, uint64_t seed, unsigned int probes, SolverPool& pool,
+                        std::vector<unsigned int>& samples);
+
+#endif // SOLUTION_SAMPLER_H
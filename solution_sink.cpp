@@ -0,0 +1,66 @@
+/**
+ * @file    solution_sink.cpp
+ * @brief   Implements the sequential solvers that hand their solutions to a sink.
+ */
+
+#include "solution_sink.h"
+
+#include "nqueens.h"
+#include "solution_iterator.h"
+
+//the solutions handed to the sink at once, so the sink is not called per solution
+const size_t sequential_batch_solutions = 4096;
+
+//the sink and pending batch of the sequential run, used from within its nqueens_by_level callback
+struct SequentialSink
+{
+    static SolutionSink*& sink()
+    {
+        static SolutionSink* current;
+        return current;
+    }
+    static std::vector<unsigned int>& batch()
+    {
+        static std::vector<unsigned int> pending;
+        return pending;
+    }
+};
+
+/**
+ * @brief Hands the pending batch to the sink.
+ */
+void flush_batch(SolutionSink& sink, std::vector<unsigned int>& batch)
+{
+    if(!batch.empty()) sink.add_solutions(batch.data(), batch.data() + batch.size());
+    batch.clear();
+}
+
+//collects every solution found by the sequential solver into the batch
+void sink_solution_callback(std::vector<unsigned int>& solution)
+{
+    std::vector<unsigned int>& batch = SequentialSink::batch();
+    batch.insert(batch.end(), solution.begin(), solution.end());
+    if(batch.size() >= sequential_batch_solutions * solution.size()) flush_batch(*SequentialSink::sink(), batch);
+}
+
+void solve_sequential(unsigned int n, SolutionSink& sink)
+{
+    SequentialSink::sink() = &sink;
+    std::vector<unsigned int> zero(n, 0);
+    nqueens_by_level(zero, 0, n, &sink_solution_callback);
+    flush_batch(sink, SequentialSink::batch());
+    std::vector<unsigned int>().swap(SequentialSink::batch());
+    SequentialSink::sink() = NULL;
+}
+
+void solve_sequential(const Problem& problem, SolutionSink& sink)
+{
+    std::vector<unsigned int> batch;
+    SolutionIterator it(problem, NULL, 0, problem.n);
+    while(it.next())
+    {
+        batch.insert(batch.end(), it.solution(), it.solution() + problem.n);
+        if(batch.size() >= sequential_batch_solutions * problem.n) flush_batch(sink, batch);
+    }
+    flush_batch(sink, batch);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file    solution_sink.h
+ * @brief   Declares the interface through which the masters hand over the
+ *          solutions they collect, so the caller decides how they are kept.
+ */
+
+#ifndef SOLUTION_SINK_H
+#define SOLUTION_SINK_H
+
+#include <vector>
+
+#include "huge_pages.h"
+#include "problem.h"
+
+/**
+ * @brief Receives solutions in order, as concatenated runs of `n` integers.
+ */
+class SolutionSink
+{
+public:
+    virtual ~SolutionSink() {}
+
+    /**
+     * @brief Adds the solutions in [begin, end), a whole number of solutions.
+     */
+    virtual void add_solutions(const unsigned int* begin, const unsigned int* end) = 0;
+};
+
+/**
+ * @brief Appends the solutions to a vector, the flat representation used
+ *        throughout.  The vector grows in huge pages (see huge_pages.h).
+ */
+class VectorSolutionSink : public SolutionSink
+{
+public:
+    explicit VectorSolutionSink(std::vector<unsigned int>& out) : output(out) {}
+
+    void add_solutions(const unsigned int* begin, const unsigned int* end)
+    {
+        reserve_huge(output, output.size() + (end - begin));
+        output.insert(output.end(), begin, end);
+    }
+
+private:
+    std::vector<unsigned int>& output;
+};
+
+/**
+ * @brief Hands all solutions of the n-queens problem to `sink` while the
+ *        sequential solver finds them, in batches, without collecting them.
+ */
+void solve_sequential(unsigned int n, SolutionSink& sink);
+
+/**
+ * @brief Hands all solutions of a general problem to `sink` while they are found, in batches.
+ */
+void solve_sequential(const Problem& problem, SolutionSink& sink);
+
+#endif // SOLUTION_SINK_H
@@ -0,0 +1,122 @@
+/**
+ * @file    spill_store.cpp
+ * @brief   Implements the solution store that spills to disk.
+ */
+
+#include "spill_store.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+
+SpillingSolutionStore::SpillingSolutionStore(unsigned int n, size_t budget_bytes, const std::string& spill_dir)
+    : board_size(n), directory(spill_dir), spill_fd(-1), spilled_values(0), failed(false)
+{
+    budget_values = std::max<size_t>(budget_bytes / sizeof(unsigned int) / n, 1) * n;
+}
+
+SpillingSolutionStore::~SpillingSolutionStore()
+{
+    if(spill_fd >= 0) close(spill_fd);
+}
+
+void SpillingSolutionStore::add_solutions(const unsigned int* begin, const unsigned int* end)
+{
+    //the buffer never grows beyond the budget
+    if(buffer.capacity() < budget_values) buffer.reserve(budget_values);
+    while(begin < end)
+    {
+        size_t values = std::min<size_t>(end - begin, budget_values - buffer.size());
+        buffer.insert(buffer.end(), begin, begin + values);
+        begin += values;
+        if(buffer.size() == budget_values) spill();
+    }
+}
+
+void SpillingSolutionStore::spill()
+{
+    //once writing failed, further solutions are dropped; the caller learns about it from ok()
+    if(!failed) write_buffer();
+    buffer.clear();
+}
+
+void SpillingSolutionStore::write_buffer()
+{
+    if(spill_fd < 0)
+    {
+        std::string path = directory + "/nqueens-spill-XXXXXX";
+        std::vector<char> name(path.begin(), path.end());
+        name.push_back('\0');
+        spill_fd = mkstemp(name.data());
+        if(spill_fd < 0)
+        {
+            failed = true;
+            return;
+        }
+        unlink(name.data()); //only the descriptor keeps the file alive
+    }
+
+    const char* data = reinterpret_cast<const char*>(buffer.data());
+    size_t remaining = buffer.size() * sizeof(unsigned int);
+    while(remaining > 0)
+    {
+        ssize_t written = write(spill_fd, data, remaining);
+        if(written < 0 && errno == EINTR) continue;
+        if(written <= 0)
+        {
+            failed = true;
+            return;
+        }
+        data += written;
+        remaining -= written;
+    }
+    spilled_values += buffer.size();
+}
+
+SpillingSolutionStore::Cursor::Cursor(const SpillingSolutionStore& s)
+    : store(s), chunk_position(0), file_position(0), memory_position(0), current(NULL)
+{
+}
+
+bool SpillingSolutionStore::Cursor::next()
+{
+    unsigned int n = store.board_size;
+    if(chunk_position < chunk.size())
+    {
+        current = chunk.data() + chunk_position;
+        chunk_position += n;
+        return true;
+    }
+    if(file_position < store.spilled_values)
+    {
+        //read the next chunk of the spill file, at most one budget of whole solutions
+        chunk.resize(std::min(store.budget_values, store.spilled_values - file_position));
+        char* data = reinterpret_cast<char*>(chunk.data());
+        size_t remaining = chunk.size() * sizeof(unsigned int);
+        off_t offset = file_position * sizeof(unsigned int);
+        while(remaining > 0)
+        {
+            ssize_t num_read = pread(store.spill_fd, data, remaining, offset);
+            if(num_read < 0 && errno == EINTR) continue;
+            if(num_read <= 0) return false;
+            data += num_read;
+            offset += num_read;
+            remaining -= num_read;
+        }
+        file_position += chunk.size();
+        current = chunk.data();
+        chunk_position = n;
+        return true;
+    }
+    //the spill file is done, continue with the solutions still in memory
+    std::vector<unsigned int>().swap(chunk);
+    chunk_position = 0;
+    if(memory_position < store.buffer.size())
+    {
+        current = store.buffer.data() + memory_position;
+        memory_position += n;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file    spill_store.h
+ * @brief   Declares a solution store with a fixed memory budget, which spills
+ *          solutions to a file on local disk once the budget is used up.
+ *
+ * The solutions reach the store in their final (lexicographic) order, see
+ * reorder_buffer.h, so the spilled chunks form a single sorted run: the store
+ * appends each full buffer to one spill file and iteration reads the file
+ * back sequentially, followed by the solutions still in memory.  No merge
+ * pass is needed.
+ */
+
+#ifndef SPILL_STORE_H
+#define SPILL_STORE_H
+
+#include <vector>
+#include <string>
+#include <stddef.h>
+
+#include "solution_sink.h"
+
+/**
+ * @brief Stores solutions in order, using at most a given amount of memory.
+ *
+ * The spill file is created on the first spill and removed when the store is
+ * destroyed (it is unlinked right after creation, so it also disappears if
+ * the process dies).
+ */
+class SpillingSolutionStore : public SolutionSink
+{
+public:
+    /**
+     * @param n             The size of the chessboard.
+     * @param budget_bytes  Memory for solutions held in memory, and for the
+     *                      read buffer of each cursor.  At least one solution.
+     * @param spill_dir     Directory of the spill file.
+     */
+    SpillingSolutionStore(unsigned int n, size_t budget_bytes, const std::string& spill_dir);
+    ~SpillingSolutionStore();
+
+    void add_solutions(const unsigned int* begin, const unsigned int* end);
+
+    unsigned int n() const { return board_size; }
+    //the number of stored solutions
+    size_t size() const { return (spilled_values + buffer.size()) / board_size; }
+    //the number of bytes written to the spill file
+    size_t spilled_bytes() const { return spilled_values * sizeof(unsigned int); }
+    //false if writing the spill file failed; the store is incomplete then
+    bool ok() const { return !failed; }
+
+    /**
+     * @brief Iterates over the solutions in order.
+     *
+     *     SpillingSolutionStore::Cursor cursor(store);
+     *     while(cursor.next()) use(cursor.solution());
+     */
+    class Cursor
+    {
+    public:
+        explicit Cursor(const SpillingSolutionStore& store);
+
+        /**
+         * @brief Moves to the next solution.  Returns false after the last one.
+         */
+        bool next();
+        const unsigned int* solution() const { return current; }
+
+    private:
+        const SpillingSolutionStore& store;
+        std::vector<unsigned int> chunk; //values read from the spill file
+        size_t chunk_position; //next value of the chunk
+        size_t file_position; //next value of the spill file
+        size_t memory_position; //next value of the store's buffer
+        const unsigned int* current;
+    };
+
+private:
+    SpillingSolutionStore(const SpillingSolutionStore&);
+    SpillingSolutionStore& operator=(const SpillingSolutionStore&);
+
+    void spill();
+    void write_buffer();
+
+    unsigned int board_size;
+    size_t budget_values; //values held in memory before spilling, a whole number of solutions
+    std::string directory;
+    std::vector<unsigned int> buffer;
+    int spill_fd;
+    size_t spilled_values;
+    bool failed;
+};
+
+#endif // SPILL_STORE_H
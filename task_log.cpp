@@ -0,0 +1,63 @@
+/**
+ * @file    task_log.cpp
+ * @brief   Implements reading and writing of task logs.
+ */
+
+#include "task_log.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+bool write_task_log(const std::string& path, const TaskLog& log)
+{
+    std::ofstream out(path.c_str());
+    if(!out) return false;
+    out << "# task worker cost_ns num_solutions dispatch_us result_us prefix..." << std::endl;
+    out << "n " << log.n << " k " << log.k << " p " << log.p << std::endl;
+    for(size_t i = 0; i < log.tasks.size(); ++i)
+    {
+        const TaskRecord& task = log.tasks[i];
+        out << task.task_id << ' ' << task.worker << ' ' << task.cost_ns << ' ' << task.num_solutions << ' '
+            << static_cast<uint64_t>(task.dispatch_us) << ' ' << static_cast<uint64_t>(task.result_us);
+        for(size_t j = 0; j < task.prefix.size(); ++j) out << ' ' << task.prefix[j];
+        out << '\n';
+    }
+    return static_cast<bool>(out);
+}
+
+/**
+ * @brief Orders tasks by their id.
+ */
+bool task_id_less(const TaskRecord& a, const TaskRecord& b)
+{
+    return a.task_id < b.task_id;
+}
+
+bool read_task_log(const std::string& path, TaskLog& log)
+{
+    std::ifstream in(path.c_str());
+    if(!in) return false;
+    std::string line, key_n, key_k, key_p;
+    bool have_header = false;
+    log.tasks.clear();
+    while(std::getline(in, line))
+    {
+        if(line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        if(!have_header)
+        {
+            if(!(fields >> key_n >> log.n >> key_k >> log.k >> key_p >> log.p) || key_n != "n" || key_k != "k" || key_p != "p") return false;
+            have_header = true;
+            continue;
+        }
+        TaskRecord task;
+        if(!(fields >> task.task_id >> task.worker >> task.cost_ns >> task.num_solutions >> task.dispatch_us >> task.result_us)) return false;
+        task.prefix.resize(log.k);
+        for(unsigned int j = 0; j < log.k; ++j)
+            if(!(fields >> task.prefix[j])) return false;
+        log.tasks.push_back(task);
+    }
+    std::sort(log.tasks.begin(), log.tasks.end(), task_id_less);
+    return have_header;
+}
@@ -0,0 +1,53 @@
+/**
+ * @file    task_log.h
+ * @brief   Declares the per-task log of a master-worker run, as written by
+ *          `./nqueens -l <file>` and replayed by the scheduler simulator.
+ *
+ * The log is a text file: a header line `n <n> k <k> p <p>` followed by one
+ * line per task
+ *
+ *     <task> <worker> <cost_ns> <num_solutions> <dispatch_us> <result_us> <prefix...>
+ *
+ * where `cost_ns` is the time the worker spent completing the prefix and
+ * `dispatch_us`/`result_us` are the master's clock when it sent the task and
+ * received its result, relative to the start of the run.  Lines starting
+ * with `#` are comments.
+ */
+
+#ifndef TASK_LOG_H
+#define TASK_LOG_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+//everything recorded about one task of a run
+struct TaskRecord
+{
+    unsigned int task_id;
+    unsigned int worker;
+    uint64_t cost_ns;
+    uint64_t num_solutions;
+    double dispatch_us;
+    double result_us;
+    std::vector<unsigned int> prefix;
+};
+
+//the log of a whole run
+struct TaskLog
+{
+    unsigned int n, k, p;
+    std::vector<TaskRecord> tasks; //ordered by task id
+};
+
+/**
+ * @brief Writes the log to a file.  Returns false if it could not be written.
+ */
+bool write_task_log(const std::string& path, const TaskLog& log);
+
+/**
+ * @brief Reads a log written by write_task_log().  Returns false on errors.
+ */
+bool read_task_log(const std::string& path, TaskLog& log);
+
+#endif // TASK_LOG_H
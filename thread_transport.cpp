@@ -0,0 +1,47 @@
+/**
+ * @file    thread_transport.cpp
+ * @brief   Implements the in-process thread transport.
+ */
+
+#include "thread_transport.h"
+
+#include <thread>
+
+ThreadTransportGroup::ThreadTransportGroup(int size)
+{
+    for(int i = 0; i < size; ++i) mailboxes.push_back(std::unique_ptr<MpscQueue<Message> >(new MpscQueue<Message>()));
+}
+
+ThreadTransport::ThreadTransport(ThreadTransportGroup& group, int rank) : group(group), my_rank(rank) {}
+
+void ThreadTransport::send(int dest, int tag, const unsigned int* data, size_t count)
+{
+    Message message;
+    message.source = my_rank;
+    message.tag = tag;
+    message.data.assign(data, data + count);
+    group.mailbox(dest).push(std::move(message));
+}
+
+void ThreadTransport::recv(int source, Message& message)
+{
+    //messages set aside by an earlier receive come first, they are older than anything in the mailbox
+    for(std::deque<Message>::iterator it = pending.begin(); it != pending.end(); ++it)
+    {
+        if(source == any_source || it->source == source)
+        {
+            message = std::move(*it);
+            pending.erase(it);
+            return;
+        }
+    }
+    while(true)
+    {
+        if(group.mailbox(my_rank).pop(message))
+        {
+            if(source == any_source || message.source == source) return;
+            pending.push_back(std::move(message));
+        }
+        else std::this_thread::yield();
+    }
+}
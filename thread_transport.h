@@ -0,0 +1,53 @@
+/**
+ * @file    thread_transport.h
+ * @brief   Declares the in-process transport, connecting threads through
+ *          lock-free queues.
+ */
+
+#ifndef THREAD_TRANSPORT_H
+#define THREAD_TRANSPORT_H
+
+#include <deque>
+#include <memory>
+
+#include "transport.h"
+#include "lockfree_queue.h"
+
+/**
+ * @brief The shared mailboxes of a group of threads: one lock-free queue per rank.
+ */
+class ThreadTransportGroup
+{
+public:
+    explicit ThreadTransportGroup(int size);
+
+    int size() const { return mailboxes.size(); }
+    MpscQueue<Message>& mailbox(int rank) { return *mailboxes[rank]; }
+
+private:
+    std::vector<std::unique_ptr<MpscQueue<Message> > > mailboxes;
+};
+
+/**
+ * @brief The endpoint of one thread in a ThreadTransportGroup.
+ *
+ * Sending moves a copy of the data into the receiver's mailbox; receiving
+ * spins (yielding the core) until a message arrives.
+ */
+class ThreadTransport : public Transport
+{
+public:
+    ThreadTransport(ThreadTransportGroup& group, int rank);
+
+    int rank() const { return my_rank; }
+    int size() const { return group.size(); }
+    void send(int dest, int tag, const unsigned int* data, size_t count);
+    void recv(int source, Message& message);
+
+private:
+    ThreadTransportGroup& group;
+    int my_rank;
+    std::deque<Message> pending; //messages taken from the mailbox that did not match the requested source
+};
+
+#endif // THREAD_TRANSPORT_H
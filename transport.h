@@ -0,0 +1,60 @@
+/**
+ * @file    transport.h
+ * @brief   Declares the message transport used by the master-worker solver.
+ *
+ * The master-worker protocol only needs point-to-point messages of unsigned
+ * integers between numbered endpoints (ranks), with the master at rank 0.
+ * Implementations exist for MPI (mpi_transport.h), for threads of one
+ * process (thread_transport.h) and for processes on one node sharing memory
+ * (shm_transport.h).
+ */
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <vector>
+#include <stddef.h>
+
+//receive from whichever endpoint sends first
+const int any_source = -1;
+
+//a received message
+struct Message
+{
+    int source;
+    int tag;
+    std::vector<unsigned int> data;
+};
+
+/**
+ * @brief One endpoint of a group of communicating ranks.
+ *
+ * Messages between a pair of endpoints are received in the order they were
+ * sent.  Sends may block until the receiver has made room, receives block
+ * until a message is available.
+ */
+class Transport
+{
+public:
+    virtual ~Transport() {}
+
+    //the rank of this endpoint in [0, size())
+    virtual int rank() const = 0;
+    //the number of endpoints in the group
+    virtual int size() const = 0;
+
+    /**
+     * @brief Sends `count` integers with the given tag to rank `dest`.
+     */
+    virtual void send(int dest, int tag, const unsigned int* data, size_t count) = 0;
+
+    /**
+     * @brief Receives the next message from `source` (or from any rank if
+     *        `source` is any_source) into `message`, blocking until one arrives.
+     */
+    virtual void recv(int source, Message& message) = 0;
+
+    void send(int dest, int tag, const std::vector<unsigned int>& data) { send(dest, tag, data.data(), data.size()); }
+};
+
+#endif // TRANSPORT_H